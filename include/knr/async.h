@@ -0,0 +1,67 @@
+#ifndef ASYNC_H
+#define ASYNC_H
+
+#include <knr/canny.h>
+#include <knr/executor.h>
+#include <opencv2/core/mat.hpp>
+
+#include <coroutine>
+#include <expected>
+#include <functional>
+#include <future>
+#include <optional>
+#include <stop_token>
+#include <string>
+
+namespace kd {
+
+using CannyExpected = std::expected<CannyOutputs, std::string>;
+
+// Invoked on an executor worker, where an exception would take down the whole process; hence noexcept
+using CannyCallback = std::move_only_function<void(CannyExpected) noexcept>;
+
+// Queues run_canny on `executor`; on_done is then invoked on a worker w/ the outputs, an error or a cancellation
+// `stop` is checked before every stage, so stale jobs bail out early, or without running at all if still queued
+// img is shared, not copied; don't write to it until on_done has run
+// The convolution is capped to the job's share of the cores (cores / executor workers), see CannyCfg::max_threads
+// Fails, without ever invoking on_done, if the executor's queue is full
+std::expected<void, std::string> run_canny_async(cv::Mat img, CannyCfg cfg, const CannyStage outputs,
+                                                 CannyCallback on_done,
+                                                 const Priority prio = Priority::Normal, std::stop_token stop = {},
+                                                 Executor &executor = default_executor());
+
+// std::future flavour of the above; a full queue is reported through the future
+std::future<CannyExpected> run_canny_async(cv::Mat img, CannyCfg cfg, const CannyStage outputs,
+                                           const Priority prio = Priority::Normal, std::stop_token stop = {},
+                                           Executor &executor = default_executor());
+
+// Coroutine flavour: `auto outputs{co_await await_canny(img, cfg, CannyStage::Edges)};`
+// The awaiting coroutine is resumed on the executor's worker, or right away if the job couldn't be queued
+// As w/ CannyCallback, nothing may escape that resumption: the coroutine's promise must not rethrow from
+// unhandled_exception (or the process terminates)
+class CannyAwaitable {
+  public:
+    CannyAwaitable(cv::Mat img, CannyCfg cfg, const CannyStage outputs, const Priority prio, std::stop_token stop,
+                   Executor &executor);
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> handle);
+    CannyExpected await_resume() { return std::move(*result_); }
+
+  private:
+    cv::Mat img_;
+    CannyCfg cfg_;
+    CannyStage outputs_;
+    Priority prio_;
+    std::stop_token stop_;
+    Executor *executor_;
+    std::optional<CannyExpected> result_{};
+};
+
+CannyAwaitable await_canny(cv::Mat img, CannyCfg cfg, const CannyStage outputs,
+                           const Priority prio = Priority::Normal, std::stop_token stop = {},
+                           Executor &executor = default_executor());
+
+} // namespace kd
+
+#endif // ASYNC_H
@@ -1,9 +1,15 @@
 #ifndef CANNY_H
 #define CANNY_H
 
+#include <knr/threshold.h>
+#include <knr/tune.h>
 #include <opencv2/opencv.hpp>
 
+#include <cstdint>
 #include <expected>
+#include <optional>
+#include <stop_token>
+#include <utility>
 
 namespace kd {
 
@@ -13,10 +19,56 @@ struct CannyCfg {
     int low_threshold;
     int high_threshold;
     std::string out_dir;
+    std::optional<ConvPlan> conv_plan{};               // Forces a convolution backend; autotuned if unset
+    std::string tune_cache{default_tune_cache_path()}; // Where autotuned plans persist; empty to skip persisting
+    ThresholdMode threshold_mode{ThresholdMode::Fixed}; // Non-fixed modes ignore low/high_threshold
+    float threshold_percentile{0.8f};                  // Only read by ThresholdMode::Percentile
+    int max_threads{};                                 // Caps the convolution's thread count; 0 for every core
 };
 
-std::expected<cv::Mat, std::string> canny_edge_detector(const std::string &img_name, const cv::Mat &img,
-                                                        const CannyCfg &args, bool save_intermediates);
+struct CannyResult {
+    cv::Mat edges;
+    Thresholds thresholds; // The hysteresis thresholds actually used; auto-selected ones included
+};
+
+// Outputs run_canny can be asked for; combine w/ |
+enum class CannyStage : std::uint8_t {
+    None      = 0,
+    Gradients = 1 << 0, // fx & fy
+    Direction = 1 << 1,
+    Magnitude = 1 << 2,
+    Nms       = 1 << 3,
+    Edges     = 1 << 4,
+};
+
+constexpr CannyStage operator|(const CannyStage a, const CannyStage b) {
+    return static_cast<CannyStage>(std::to_underlying(a) | std::to_underlying(b));
+}
+
+constexpr bool has_stage(const CannyStage stages, const CannyStage stage) {
+    return (std::to_underlying(stages) & std::to_underlying(stage)) != 0;
+}
+
+// Only the requested outputs are set
+struct CannyOutputs {
+    std::optional<cv::Mat> fx;
+    std::optional<cv::Mat> fy;
+    std::optional<cv::Mat> direction;
+    std::optional<cv::Mat> magnitude;
+    std::optional<cv::Mat> nms;
+    std::optional<cv::Mat> edges;
+    std::optional<Thresholds> thresholds; // Set alongside edges
+};
+
+// Runs only the stages the requested outputs depend on, and hands them back in memory
+// e.g. asking for Magnitude alone skips direction, NMS and hysteresis altogether
+// `stop` is checked between stages; once stop is requested the run bails out with an error
+std::expected<CannyOutputs, std::string> run_canny(const cv::Mat &img, const CannyCfg &cfg, const CannyStage outputs,
+                                                   const std::stop_token &stop = {});
+
+// Full pipeline; saves magnitude & NMS to cfg.out_dir if save_intermediates is set
+std::expected<CannyResult, std::string> canny_edge_detector(const std::string &img_name, const cv::Mat &img,
+                                                            const CannyCfg &args, bool save_intermediates);
 } // namespace kd
 
 #endif // CANNY_H
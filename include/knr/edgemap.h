@@ -0,0 +1,53 @@
+#ifndef EDGEMAP_H
+#define EDGEMAP_H
+
+#include <opencv2/core/mat.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <string>
+
+namespace kd {
+
+// Writes an edge map (8UC1; any non-zero pixel is an edge) as a binary PBM (P4)
+// 1 bit per pixel, MSB first, every row padded to a whole byte; 1 = edge (so viewers draw edges black on white)
+// An existing file at path is replaced atomically, so a MappedEdgeMap of it stays valid
+std::expected<void, std::string> write_edge_map(const cv::Mat &edges, const std::string &path);
+
+// Read-only view of a P4 PBM edge map, mmap'd rather than decoded; rows point straight into the mapping
+class MappedEdgeMap {
+  public:
+    static std::expected<MappedEdgeMap, std::string> open(const std::string &path);
+
+    ~MappedEdgeMap();
+
+    MappedEdgeMap(MappedEdgeMap &&other) noexcept;
+    MappedEdgeMap &operator=(MappedEdgeMap &&other) noexcept;
+    MappedEdgeMap(const MappedEdgeMap &)            = delete;
+    MappedEdgeMap &operator=(const MappedEdgeMap &) = delete;
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    std::size_t stride() const { return (static_cast<std::size_t>(cols_) + 7) / 8; } // Bytes per packed row
+
+    std::span<const std::uint8_t> row(const int y) const { return {bits_ + y * stride(), stride()}; }
+    bool at(const int y, const int x) const { return (row(y)[x / 8] >> (7 - x % 8)) & 1; }
+
+    // Expands to an 8UC1 matrix (255 = edge); a copy, for handing to code that wants pixels
+    cv::Mat unpack() const;
+
+  private:
+    MappedEdgeMap(void *map, const std::size_t map_len, const std::uint8_t *bits, const int rows, const int cols);
+
+    void *map_{};
+    std::size_t map_len_{};
+    const std::uint8_t *bits_{};
+    int rows_{};
+    int cols_{};
+};
+
+} // namespace kd
+
+#endif // EDGEMAP_H
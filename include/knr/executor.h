@@ -0,0 +1,62 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace kd {
+
+enum class Priority : std::uint8_t {
+    Bulk        = 0,
+    Normal      = 1,
+    Interactive = 2, // Latency-critical; dequeued ahead of everything else
+};
+
+// A fixed pool of workers draining a bounded priority queue
+// Higher priorities are dequeued first; equal priorities run in submission order
+// Running jobs are never interrupted, they're expected to check for cancellation themselves
+class Executor {
+  public:
+    explicit Executor(const unsigned workers, const std::size_t capacity);
+    ~Executor(); // Runs whatever is still queued, then joins
+
+    Executor(const Executor &)            = delete;
+    Executor &operator=(const Executor &) = delete;
+
+    // Fails instead of blocking once `capacity` jobs are queued, so callers can shed load
+    std::expected<void, std::string> submit(std::move_only_function<void()> job, const Priority prio);
+
+    unsigned workers() const { return static_cast<unsigned>(workers_.size()); }
+
+  private:
+    struct Job {
+        Priority prio;
+        std::uint64_t seq;
+        std::move_only_function<void()> fn;
+    };
+
+    static bool runs_after(const Job &a, const Job &b);
+
+    void work(std::stop_token stop);
+
+    std::size_t capacity_;
+    std::uint64_t next_seq_{};
+    std::vector<Job> queue_{}; // Heap, ordered by runs_after
+    std::mutex mtx_{};
+    std::condition_variable_any cv_{};
+    std::vector<std::jthread> workers_{}; // Last, so workers are joined before the queue goes away
+};
+
+// Library-owned executor shared by the async entry points: one worker per core, 1024 queued jobs at most
+Executor &default_executor();
+
+} // namespace kd
+
+#endif // EXECUTOR_H
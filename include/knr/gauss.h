@@ -13,18 +13,46 @@ int compute_filter_size(float sigma, float T);
 
 // Generates a normalized gaussian filter of floats
 // G (x, y) = exp (-(x^2 + y^2)/(2*sigma^2))
+// NOTE: the pipeline now builds Gx/Gy from quantized 1D factors instead (see below); this & the overload of
+// compute_gaussian_derivatives that takes its output are kept for library callers
 std::expected<cv::Mat, std::string> generate_gaussian_filter(const int filter_size, const float sigma);
 
 // Computes Gx and Gy given a matrix of floats representing a Gaussian filter
-// Gx and Gy hold 16 bit integers
+// Gx and Gy hold 16 bit integers (scaled by 256); convolve them w/ convolve_through_image
 std::expected<std::pair<cv::Mat, cv::Mat>, std::string> compute_gaussian_derivatives(const cv::Mat &filt_f,
                                                                                      const float sigma);
 
+// Computes the 1D factors of Gx and Gy: as G(x, y) = g(x) * g(y), Gx = g'(x) * g(y) and Gy = g(x) * g'(y)
+// Returns {g', g}, both 1xN matrices of 16 bit integers (scaled by 256)
+std::expected<std::pair<cv::Mat, cv::Mat>, std::string> compute_separable_gaussian_derivatives(const int filter_size,
+                                                                                               const float sigma);
+
+// Computes Gx and Gy as the outer products of the (already quantized) 1D factors {g', g}
+// Gx and Gy hold 16 bit integers (scaled by 256 * 256); convolve them w/ convolve_rescaled_through_image, which,
+// them being exact products, agrees bit for bit w/ convolve_separable_through_image
+std::expected<std::pair<cv::Mat, cv::Mat>, std::string> compute_gaussian_derivatives(const cv::Mat &dg,
+                                                                                     const cv::Mat &g);
+
 // Convolves a first-order Gaussian derivative (Gx or Gy) through a (padded!) source image
 // img is 8UC1 (grayscale)
 // fogd is 16SC1 (16 bit signed int)
-// returns 32SC1 image (fx/fy) of edge detections as per input fogd (gx/gy)
-std::expected<cv::Mat, std::string> convolve_through_image(const cv::Mat &img_padded, const cv::Mat &fogd);
+// Output rows are split between `threads` workers
+// returns 32SC1 image (fx/fy) of edge detections as per input fogd (gx/gy), at fogd's scale
+std::expected<cv::Mat, std::string> convolve_through_image(const cv::Mat &img_padded, const cv::Mat &fogd,
+                                                           const int threads = 1);
+
+// Same as above, for a fogd scaled by 256 * 256 (compute_gaussian_derivatives(dg, g)'s); sums are rounded back down to
+// a factor of 256, exactly as convolve_separable_through_image does
+std::expected<cv::Mat, std::string> convolve_rescaled_through_image(const cv::Mat &img_padded, const cv::Mat &fogd,
+                                                                    const int threads = 1);
+
+// Separable counterpart of convolve_rescaled_through_image: a pass along x with kern_x followed by a pass along y w/
+// kern_y
+// img is 8UC1 (grayscale), padded as for convolve_through_image
+// kern_x & kern_y are 1xN 16SC1, e.g. {g', g} for fx and {g, g'} for fy
+// returns 32SC1 image (fx/fy) scaled by 256, identical to convolve_rescaled_through_image's w/ their outer product
+std::expected<cv::Mat, std::string> convolve_separable_through_image(const cv::Mat &img_padded, const cv::Mat &kern_x,
+                                                                     const cv::Mat &kern_y, const int threads = 1);
 
 // Takes 2x 32SC1 (fx, fy)
 // returns the QUANTIZED gradient direction as an 8UC1 matrix
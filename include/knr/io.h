@@ -3,14 +3,35 @@
 
 #include <opencv2/opencv.hpp>
 
+#include <cstdint>
 #include <expected>
+#include <string>
+#include <string_view>
 
 namespace kd {
 
+// How the final edge map is saved
+enum class EdgeFormat : std::uint8_t {
+    Jpg = 0, // Via save_image, like the intermediates
+    Pbm = 1, // Via save_edge_map; 1-bit packed, see kd::MappedEdgeMap
+};
+
+std::string_view to_string(const EdgeFormat format);
+
+std::expected<EdgeFormat, std::string> parse_edge_format(std::string_view name);
+
 std::expected<cv::Mat, std::string> load_image(const std::string &path);
 
-std::expected<void, std::string> save_image(const cv::Mat &img, const std::string &out_dir, const std::string &name,
-                                            const std::string &phase, const float sigma);
+// Returns the path the image was written to
+std::expected<std::string, std::string> save_image(const cv::Mat &img, const std::string &out_dir,
+                                                   const std::string &name, const std::string &phase,
+                                                   const float sigma);
+
+// Same naming as save_image, but writes a binary edge map as a 1-bit packed PBM (see write_edge_map)
+// Returns the path the edge map was written to
+std::expected<std::string, std::string> save_edge_map(const cv::Mat &edges, const std::string &out_dir,
+                                                      const std::string &name, const std::string &phase,
+                                                      const float sigma);
 
 } // namespace kd
 
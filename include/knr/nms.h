@@ -1,6 +1,7 @@
 #ifndef NMS_H
 #define NMS_H
 
+#include <knr/utils.h>
 #include <opencv2/core/mat.hpp>
 
 #include <expected>
@@ -12,6 +13,11 @@ namespace kd {
 // Returns 8UC1
 std::expected<cv::Mat, std::string> non_maximum_suppression(const cv::Mat &grad_mag, const cv::Mat &grad_dir);
 
+// Same as above, but also tallies every surviving (non-zero) response into hist while at it
+// hist is overwritten
+std::expected<cv::Mat, std::string> non_maximum_suppression(const cv::Mat &grad_mag, const cv::Mat &grad_dir,
+                                                            Histogram &hist);
+
 } // namespace kd
 
 #endif // NMS_H
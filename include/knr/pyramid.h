@@ -0,0 +1,54 @@
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+#include <knr/canny.h>
+#include <knr/threshold.h>
+#include <opencv2/core/mat.hpp>
+
+#include <cstdint>
+#include <expected>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace kd {
+
+// How per-scale edge maps are merged into one
+enum class ScaleCombine : std::uint8_t {
+    // The coarsest scale's edges, tracked down level by level onto the finer gradient's ridge within a pixel of them:
+    // fine-only detail (e.g. noise) is pruned, while coarse-only edges are kept & come out as thin as fine ones
+    CoarseToFine = 0,
+    Union        = 1, // An edge at any scale; coarse edges come out as thick as their scale factor
+};
+
+struct MultiScaleResult {
+    cv::Mat edges;                      // At the input's resolution
+    std::vector<Thresholds> thresholds; // Per level, finest first
+};
+
+std::string_view to_string(const ScaleCombine combine);
+
+std::expected<ScaleCombine, std::string> parse_scale_combine(std::string_view name);
+
+// Halves an 8UC1 image: a separable 5-tap binomial blur ([1 4 6 4 1] / 16), keeping every other row & column
+// Borders are replicated rather than zero-padded, so they don't darken
+std::expected<cv::Mat, std::string> pyr_down(const cv::Mat &img);
+
+// Level 0 is img itself, every next level is pyr_down of the previous
+// Stops short of `levels` rather than produce a level w/ a side under 16px
+std::expected<std::vector<cv::Mat>, std::string> build_gaussian_pyramid(const cv::Mat &img, const int levels);
+
+// Runs the pipeline on every level of a Gaussian pyramid w/ cfg's (small, fixed) sigma and merges the per-level edge
+// maps; a much cheaper way of catching coarse edges than a large-sigma pass at full resolution
+std::expected<MultiScaleResult, std::string> multiscale_canny(const cv::Mat &img, const CannyCfg &cfg, const int levels,
+                                                              const ScaleCombine combine);
+
+// As above; also saves every level's magnitude & NMS to cfg.out_dir (at that level's resolution, named w/ a _L<level>
+// suffix, finest = 0) if save_intermediates is set
+std::expected<MultiScaleResult, std::string> multiscale_canny(const std::string &img_name, const cv::Mat &img,
+                                                              const CannyCfg &cfg, const int levels,
+                                                              const ScaleCombine combine, bool save_intermediates);
+
+} // namespace kd
+
+#endif // PYRAMID_H
@@ -0,0 +1,36 @@
+#ifndef THRESHOLD_H
+#define THRESHOLD_H
+
+#include <knr/utils.h>
+
+#include <cstdint>
+#include <expected>
+#include <string>
+#include <string_view>
+
+namespace kd {
+
+enum class ThresholdMode : std::uint8_t {
+    Fixed      = 0, // Use the configured low/high thresholds as-is
+    Otsu       = 1, // High threshold splits the NMS responses per Otsu's method
+    Percentile = 2, // High threshold sits at a percentile of the NMS responses
+};
+
+struct Thresholds {
+    int low;
+    int high;
+};
+
+std::string_view to_string(const ThresholdMode mode);
+
+std::expected<ThresholdMode, std::string> parse_threshold_mode(std::string_view name);
+
+// Derives hysteresis thresholds from a histogram of the non-zero NMS responses
+// The high threshold comes from `mode` (percentile in (0, 1) is only read by ThresholdMode::Percentile), the low
+// threshold is half of it; both are clamped such that 0 < low < high <= 255, as apply_hysteresis expects
+std::expected<Thresholds, std::string> select_thresholds(const Histogram &hist, const ThresholdMode mode,
+                                                         const float percentile);
+
+} // namespace kd
+
+#endif // THRESHOLD_H
@@ -0,0 +1,47 @@
+#ifndef TUNE_H
+#define TUNE_H
+
+#include <opencv2/core/mat.hpp>
+
+#include <cstdint>
+#include <expected>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace kd {
+
+enum class ConvBackend : std::uint8_t {
+    Direct    = 0, // 2D FOGD; O(k^2) per pixel
+    Separable = 1, // 1D pass along x, then along y; O(2k) per pixel
+};
+
+struct ConvPlan {
+    ConvBackend backend;
+    int threads;
+};
+
+std::string_view to_string(const ConvBackend backend);
+
+std::expected<ConvBackend, std::string> parse_conv_backend(std::string_view name);
+
+// $XDG_CACHE_HOME/knr/tune.cache, falling back to $HOME/.cache/knr/tune.cache
+// Empty if neither is set, in which case tuning results only live for the duration of the process
+std::string default_tune_cache_path();
+
+// Picks the fastest convolution plan for a (filter size, image width bucket, thread budget)
+// max_threads is the budget: at most that many threads, or every core if 0 (or more than there are cores)
+// On first use every candidate (backend x thread count within the budget) is timed on a fixed band of img_padded's
+// rows; the winner is memoized in-process and persisted to cache_path (if non-empty) so later runs dispatch to it
+// without re-timing
+// Only one key is timed at a time, but lookups of already-tuned keys never wait on it
+// `contended` says other work is running in-process; the winner is then only memoized, provisionally, and re-tuned by
+// the first uncontended call for the key
+// gx is the 16SC1 2D FOGD (scaled by 256 * 256), sep holds its {g', g} 1D factors
+std::expected<ConvPlan, std::string> select_conv_plan(const cv::Mat &img_padded, const cv::Mat &gx,
+                                                      const std::pair<cv::Mat, cv::Mat> &sep, const int max_threads,
+                                                      const std::string &cache_path, const bool contended = false);
+
+} // namespace kd
+
+#endif // TUNE_H
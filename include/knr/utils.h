@@ -3,11 +3,19 @@
 
 #include <opencv2/core/mat.hpp>
 
+#include <array>
 #include <cstdint>
+#include <functional>
+#include <optional>
 
 namespace kd {
 cv::Mat pad_image(const cv::Mat &img, const int padding);
 
+// Splits [begin, end) into `threads` contiguous chunks and runs body(chunk_begin, chunk_end) on each, spread across a
+// persistent process-wide pool (one thread per core, the caller included); returns once every chunk is done
+// threads <= 1 runs body inline on the calling thread
+void parallel_for_rows(const int begin, const int end, const int threads, const std::function<void(int, int)> &body);
+
 /*
  * This is wholly unnecessary but I just wanted to play around w/ scoped enums and their goofy little operator overload.
  */
@@ -23,6 +31,14 @@ std::uint8_t operator+(const GradientDir gd);
 
 using Px = std::pair<int, int>;
 
+// The (dy, dx) step along a quantized gradient direction, i.e. across the edge: a pixel's neighbours along its gradient
+// are px - step & px + step
+// Empty for GradientDir::Invalid
+std::optional<Px> gradient_step(const GradientDir gd);
+
+// Bin i counts the pixels of intensity i in an 8UC1 matrix
+using Histogram = std::array<std::uint32_t, 256>;
+
 } // namespace kd
 
 #endif // UTILS_H
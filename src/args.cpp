@@ -1,14 +1,33 @@
 #include "args.h"
 
+#include <algorithm>
+#include <thread>
+
 std::expected<ArgConfig, std::string> parse_args(int argc, char *argv[]) {
     argparse::ArgumentParser prog("knr", "v2025-09-17a", argparse::default_arguments::help);
 
     ArgConfig args{};
 
-    prog.add_argument("-i").required().help("specify the input image").store_into(args.img_path);
+    prog.add_argument("-i").help("specify the input image").store_into(args.img_path);
+
+    prog.add_argument("-b", "--batch")
+        .help("specify a file listing input images, one per line, to process in place of -i")
+        .store_into(args.batch_list);
+
+    prog.add_argument("--shard")
+        .help("specify the slice i/N (0-based) of the sorted batch this run processes")
+        .default_value(std::string{"0/1"});
+
+    prog.add_argument("--manifest")
+        .help("specify where the batch records completed items (default: <output-dir>/manifest_<i>-of-<N>_<cfg>.tsv)")
+        .store_into(args.manifest);
 
     prog.add_argument("-o", "--output-dir").required().help("specify the output dir").store_into(args.out_dir);
 
+    prog.add_argument("-f", "--format")
+        .help("specify the edge map's format: jpg, or pbm (1-bit packed, see kd::MappedEdgeMap)")
+        .default_value(std::string{"jpg"});
+
     prog.add_argument("-s", "--sigma")
         .help("specify value of sigma to be used for determining the Gaussian filter's size")
         .default_value(1.4f)
@@ -34,6 +53,39 @@ std::expected<ArgConfig, std::string> parse_args(int argc, char *argv[]) {
         .scan<'i', int>()
         .store_into(args.high_threshold);
 
+    prog.add_argument("-at", "--auto-threshold")
+        .help("specify how hysteresis thresholds are picked: fixed (-lt/-ht), otsu, or percentile")
+        .default_value(std::string{"fixed"});
+
+    prog.add_argument("-p", "--percentile")
+        .help("specify the percentile of NMS responses the high threshold sits at, for '-at percentile'")
+        .default_value(0.8f)
+        .scan<'g', float>()
+        .store_into(args.threshold_percentile);
+
+    prog.add_argument("-L", "--levels")
+        .help("specify the number of Gaussian pyramid levels to detect edges at, each w/ the same sigma")
+        .default_value(1)
+        .scan<'i', int>()
+        .store_into(args.levels);
+
+    prog.add_argument("--combine")
+        .help("specify how per-level edges are merged: confirm (coarse-to-fine confirmation) or union")
+        .default_value(std::string{"confirm"});
+
+    prog.add_argument("--backend")
+        .help("specify the convolution backend: direct, separable, or auto to autotune one")
+        .default_value(std::string{"auto"});
+
+    prog.add_argument("--threads")
+        .help("specify the thread count of a forced backend (defaults to all cores)")
+        .scan<'i', int>();
+
+    prog.add_argument("--tune-cache")
+        .help("specify the file autotuned backends persist to")
+        .default_value(kd::default_tune_cache_path())
+        .store_into(args.tune_cache);
+
     try {
         prog.parse_args(argc, argv);
     } catch (const std::exception &err) {
@@ -41,6 +93,24 @@ std::expected<ArgConfig, std::string> parse_args(int argc, char *argv[]) {
         return std::unexpected(errmsg);
     }
 
+    if (prog.is_used("-i") == prog.is_used("-b"))
+        return std::unexpected(std::format("Exactly one of -i and --batch is required\n\n{}", prog.usage()));
+
+    if (!prog.is_used("-b") && (prog.is_used("--shard") || prog.is_used("--manifest")))
+        return std::unexpected("--shard and --manifest require --batch");
+
+    const auto shard_expected{parse_shard(prog.get<std::string>("--shard"))};
+    if (!shard_expected.has_value())
+        return std::unexpected(shard_expected.error());
+
+    args.shard = shard_expected.value();
+
+    const auto edge_format_expected{kd::parse_edge_format(prog.get<std::string>("-f"))};
+    if (!edge_format_expected.has_value())
+        return std::unexpected(edge_format_expected.error());
+
+    args.edge_format = edge_format_expected.value();
+
     if (prog.is_used("-T")) {
         float f{prog.get<float>("T")};
         if (f < 0 || f > 1)
@@ -72,5 +142,70 @@ std::expected<ArgConfig, std::string> parse_args(int argc, char *argv[]) {
             return std::unexpected(std::format("Sigma can't be lower than 0.5: {}", f));
     }
 
+    const auto threshold_mode_expected{kd::parse_threshold_mode(prog.get<std::string>("-at"))};
+    if (!threshold_mode_expected.has_value())
+        return std::unexpected(threshold_mode_expected.error());
+
+    args.threshold_mode = threshold_mode_expected.value();
+
+    if (args.threshold_mode != kd::ThresholdMode::Fixed && (prog.is_used("-lt") || prog.is_used("-ht")))
+        return std::unexpected("-lt/-ht can't be combined with automatic thresholds");
+
+    if (prog.is_used("-p")) {
+        if (args.threshold_mode != kd::ThresholdMode::Percentile)
+            return std::unexpected("--percentile requires '-at percentile'");
+
+        float f{prog.get<float>("-p")};
+        if (f <= 0 || f >= 1)
+            return std::unexpected(std::format("Percentile must lie in (0,1): {}", f));
+    }
+
+    if (prog.is_used("-L")) {
+        int i{prog.get<int>("-L")};
+        if (i < 1)
+            return std::unexpected(std::format("Pyramid levels must be positive: {}", i));
+    }
+
+    const auto combine_expected{kd::parse_scale_combine(prog.get<std::string>("--combine"))};
+    if (!combine_expected.has_value())
+        return std::unexpected(combine_expected.error());
+
+    args.combine = combine_expected.value();
+
+    if (prog.is_used("--combine") && args.levels == 1)
+        return std::unexpected("--combine requires more than one pyramid level (-L)");
+
+    const auto backend{prog.get<std::string>("--backend")};
+
+    if (prog.is_used("--threads")) {
+        if (backend == "auto")
+            return std::unexpected("--threads requires a forced --backend");
+
+        int i{prog.get<int>("--threads")};
+        if (i <= 0)
+            return std::unexpected(std::format("Thread count must be positive: {}", i));
+    }
+
+    if (backend != "auto") {
+        const auto backend_expected{kd::parse_conv_backend(backend)};
+        if (!backend_expected.has_value())
+            return std::unexpected(backend_expected.error());
+
+        const int cores{std::max(1, static_cast<int>(std::thread::hardware_concurrency()))};
+        const int threads{prog.is_used("--threads") ? prog.get<int>("--threads") : cores};
+        args.conv_plan = kd::ConvPlan{backend_expected.value(), threads};
+    }
+
+    // The backend & its thread count are left out, as they all produce identical outputs
+    args.config = config_fingerprint(std::format(
+        "s={} T={} lt={} ht={} at={} p={} f={} L={} combine={}", args.sigma, args.T, args.low_threshold,
+        args.high_threshold, kd::to_string(args.threshold_mode), args.threshold_percentile,
+        kd::to_string(args.edge_format), args.levels, kd::to_string(args.combine)));
+
+    // Per config, so a re-run w/ other settings doesn't take the old outputs for its own
+    if (args.manifest.empty())
+        args.manifest = std::format("{}/manifest_{}-of-{}_{}.tsv", args.out_dir, args.shard.index, args.shard.count,
+                                    args.config);
+
     return args;
 }
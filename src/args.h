@@ -1,9 +1,16 @@
 #ifndef ARGS_H
 #define ARGS_H
 
+#include "batch.h"
+
 #include <argparse/argparse.hpp>
+#include <knr/io.h>
+#include <knr/pyramid.h>
+#include <knr/threshold.h>
+#include <knr/tune.h>
 
 #include <expected>
+#include <optional>
 #include <string>
 
 struct ArgConfig {
@@ -12,7 +19,18 @@ struct ArgConfig {
     int low_threshold;
     int high_threshold;
     std::string img_path;
+    std::string batch_list;
+    Shard shard;
+    std::string manifest;
+    std::string config; // Fingerprint of the settings below that affect outputs, see config_fingerprint
     std::string out_dir;
+    kd::EdgeFormat edge_format;
+    std::optional<kd::ConvPlan> conv_plan;
+    std::string tune_cache;
+    kd::ThresholdMode threshold_mode;
+    float threshold_percentile;
+    int levels;
+    kd::ScaleCombine combine;
 };
 
 std::expected<ArgConfig, std::string> parse_args(int argc, char *argv[]);
@@ -0,0 +1,82 @@
+#include <knr/async.h>
+
+#include <algorithm>
+#include <exception>
+#include <format>
+#include <memory>
+#include <thread>
+
+namespace kd {
+
+std::expected<void, std::string> run_canny_async(cv::Mat img, CannyCfg cfg, const CannyStage outputs,
+                                                 CannyCallback on_done,
+                                                 const Priority prio, std::stop_token stop, Executor &executor) {
+    // The executor already keeps a job running per worker; a job's convolution only gets its share of the cores on
+    // top, or a full queue would run workers x cores threads at once
+    const int cores{std::max(1, static_cast<int>(std::thread::hardware_concurrency()))};
+    const int share{std::max(1, cores / static_cast<int>(executor.workers()))};
+    cfg.max_threads = cfg.max_threads > 0 ? std::min(cfg.max_threads, share) : share;
+
+    auto job = [img = std::move(img), cfg = std::move(cfg), outputs, on_done = std::move(on_done),
+                stop = std::move(stop)]() mutable {
+        // Nothing may escape a worker thread; run_canny's exceptions become errors & on_done is noexcept
+        auto result = [&]() -> CannyExpected {
+            try {
+                return run_canny(img, cfg, outputs, stop);
+            } catch (const std::exception &e) {
+                return std::unexpected{std::format("run_canny threw: {}", e.what())};
+            }
+        }();
+
+        on_done(std::move(result));
+    };
+
+    return executor.submit(std::move(job), prio);
+}
+
+std::future<CannyExpected> run_canny_async(cv::Mat img, CannyCfg cfg, const CannyStage outputs, const Priority prio,
+                                           std::stop_token stop, Executor &executor) {
+    // Shared, as the job (and its copy of the promise) is dropped if it can't be queued
+    auto promise{std::make_shared<std::promise<CannyExpected>>()};
+    auto future{promise->get_future()};
+
+    const auto submit_expected{run_canny_async(
+        std::move(img), std::move(cfg), outputs,
+        [promise](CannyExpected result) noexcept { promise->set_value(std::move(result)); }, prio, std::move(stop),
+        executor)};
+
+    if (!submit_expected.has_value())
+        promise->set_value(std::unexpected{submit_expected.error()});
+
+    return future;
+}
+
+CannyAwaitable::CannyAwaitable(cv::Mat img, CannyCfg cfg, const CannyStage outputs, const Priority prio,
+                               std::stop_token stop, Executor &executor)
+    : img_{std::move(img)}, cfg_{std::move(cfg)}, outputs_{outputs}, prio_{prio}, stop_{std::move(stop)},
+      executor_{&executor} {}
+
+bool CannyAwaitable::await_suspend(std::coroutine_handle<> handle) {
+    // NOTE: once queued, the worker may resume (& destroy) us before this returns; `this` is off-limits after
+    const auto submit_expected{run_canny_async(
+        std::move(img_), std::move(cfg_), outputs_,
+        [this, handle](CannyExpected result) noexcept {
+            result_ = std::move(result);
+            handle.resume();
+        },
+        prio_, std::move(stop_), *executor_)};
+
+    if (!submit_expected.has_value()) {
+        result_ = std::unexpected{submit_expected.error()};
+        return false;
+    }
+
+    return true;
+}
+
+CannyAwaitable await_canny(cv::Mat img, CannyCfg cfg, const CannyStage outputs, const Priority prio,
+                           std::stop_token stop, Executor &executor) {
+    return {std::move(img), std::move(cfg), outputs, prio, std::move(stop), executor};
+}
+
+} // namespace kd
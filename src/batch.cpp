@@ -0,0 +1,256 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <print>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct ManifestEntry {
+    std::string output;
+    std::uint64_t checksum;
+    std::string config;
+};
+
+constexpr std::uint64_t fnv1a_basis{0xcbf29ce484222325};
+
+// FNV-1a (64 bit), continuing from `hash`
+std::uint64_t fnv1a(std::string_view bytes, std::uint64_t hash = fnv1a_basis) {
+    for (const char c : bytes) {
+        hash ^= static_cast<std::uint8_t>(c);
+        hash *= 0x100000001b3;
+    }
+
+    return hash;
+}
+
+// FNV-1a (64 bit) over a file's contents
+std::expected<std::uint64_t, std::string> checksum_file(const std::string &path) {
+    std::ifstream in{path, std::ios::binary};
+    if (!in)
+        return std::unexpected("Failed to open file: " + path);
+
+    std::uint64_t hash{fnv1a_basis};
+    std::array<char, 1 << 16> buf{};
+
+    while (in.read(buf.data(), buf.size()) || in.gcount() > 0)
+        hash = fnv1a({buf.data(), static_cast<std::size_t>(in.gcount())}, hash);
+
+    if (in.bad())
+        return std::unexpected("Failed to read file: " + path);
+
+    return hash;
+}
+
+std::expected<std::vector<std::string>, std::string> load_input_list(const std::string &list_path) {
+    std::ifstream in{list_path};
+    if (!in)
+        return std::unexpected("Failed to open input list: " + list_path);
+
+    std::vector<std::string> inputs{};
+    std::string line{};
+
+    // Normalized, so e.g. ./a/img.png & a/img.png count as one input
+    while (std::getline(in, line))
+        if (!line.empty() && !line.starts_with('#'))
+            inputs.emplace_back(std::filesystem::path{line}.lexically_normal().string());
+
+    std::ranges::sort(inputs);
+    const auto [first, last]{std::ranges::unique(inputs)};
+    inputs.erase(first, last);
+
+    // Checked over the whole list, not just this shard, as every shard writes to the same output dir
+    std::unordered_map<std::string, std::string> names{};
+    for (const auto &input : inputs) {
+        const auto [it, inserted]{names.emplace(batch_output_name(input), input)};
+        if (!inserted)
+            return std::unexpected(std::format("{} and {} would share output name {}", it->second, input, it->first));
+    }
+
+    return inputs;
+}
+
+// Later lines win, so a re-processed input supersedes its older entry
+// Malformed lines (e.g. one torn by a pre-emption) are ignored; their input is simply redone
+std::unordered_map<std::string, ManifestEntry> load_manifest(const std::string &manifest_path) {
+    std::unordered_map<std::string, ManifestEntry> entries{};
+
+    std::ifstream in{manifest_path};
+    std::string line{};
+
+    while (std::getline(in, line)) {
+        if (line.empty() || line.starts_with('#'))
+            continue;
+
+        std::istringstream ss{line};
+        std::string input{}, output{}, checksum{}, config{};
+        if (!std::getline(ss, input, '\t') || !std::getline(ss, output, '\t') || !std::getline(ss, checksum, '\t') ||
+            !std::getline(ss, config, '\t'))
+            continue;
+
+        std::uint64_t sum{};
+        const auto [ptr, ec]{std::from_chars(checksum.data(), checksum.data() + checksum.size(), sum, 16)};
+        if (ec != std::errc{} || ptr != checksum.data() + checksum.size())
+            continue;
+
+        entries[input] = {output, sum, config};
+    }
+
+    return entries;
+}
+
+bool is_done(const std::unordered_map<std::string, ManifestEntry> &manifest, const std::string &input,
+             const std::string &config) {
+    const auto it{manifest.find(input)};
+    if (it == manifest.end() || it->second.config != config)
+        return false;
+
+    // An output that can't even be stat'ed is simply redone
+    std::error_code e;
+    if (!std::filesystem::exists(it->second.output, e))
+        return false;
+
+    const auto checksum_expected{checksum_file(it->second.output)};
+    return checksum_expected.has_value() && checksum_expected.value() == it->second.checksum;
+}
+
+std::expected<std::ofstream, std::string> open_manifest(const std::string &manifest_path) {
+    const std::filesystem::path path{manifest_path};
+    std::error_code e;
+
+    // Another node may create the directory first, so only an error (not a `false`) counts as a failure
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), e);
+        if (e)
+            return std::unexpected("Failed to create directory: " + e.message());
+    }
+
+    const bool exists{std::filesystem::exists(path, e)};
+    if (e)
+        return std::unexpected(std::format("Failed to stat manifest {}: {}", manifest_path, e.message()));
+
+    const std::uintmax_t size{exists ? std::filesystem::file_size(path, e) : 0};
+    if (e)
+        return std::unexpected(std::format("Failed to stat manifest {}: {}", manifest_path, e.message()));
+
+    const bool fresh{size == 0};
+
+    // A pre-empted run may have left a torn last line; don't glue the next entry onto it
+    bool torn{false};
+    if (!fresh) {
+        std::ifstream in{manifest_path, std::ios::binary | std::ios::ate};
+        in.seekg(-1, std::ios::end);
+        torn = in.get() != '\n';
+    }
+
+    std::ofstream out{manifest_path, std::ios::app};
+    if (!out)
+        return std::unexpected("Failed to open manifest: " + manifest_path);
+
+    if (fresh)
+        out << "# input\toutput\tfnv1a64\tconfig\tms\n";
+    else if (torn)
+        out << '\n';
+
+    return out;
+}
+
+} // namespace
+
+std::string batch_output_name(const std::string &input) {
+    return std::format("{}_{:08x}", std::filesystem::path{input}.stem().string(),
+                       static_cast<std::uint32_t>(fnv1a(input)));
+}
+
+std::string config_fingerprint(std::string_view config) {
+    return std::format("{:08x}", static_cast<std::uint32_t>(fnv1a(config)));
+}
+
+std::expected<Shard, std::string> parse_shard(std::string_view spec) {
+    const auto slash{spec.find('/')};
+    if (slash == std::string_view::npos)
+        return std::unexpected(std::format("Shard must look like i/N: {}", spec));
+
+    Shard shard{};
+    const auto index{spec.substr(0, slash)};
+    const auto count{spec.substr(slash + 1)};
+
+    const auto [index_end, index_ec]{std::from_chars(index.data(), index.data() + index.size(), shard.index)};
+    const auto [count_end, count_ec]{std::from_chars(count.data(), count.data() + count.size(), shard.count)};
+
+    if (index_ec != std::errc{} || count_ec != std::errc{} || index_end != index.data() + index.size() ||
+        count_end != count.data() + count.size())
+        return std::unexpected(std::format("Shard must look like i/N: {}", spec));
+
+    if (shard.count <= 0 || shard.index < 0 || shard.index >= shard.count)
+        return std::unexpected(std::format("Shard index must lie in [0,N): {}", spec));
+
+    return shard;
+}
+
+std::expected<BatchStats, std::string> run_batch(const std::string &list_path, const Shard shard,
+                                                 const std::string &manifest_path, const std::string &config,
+                                                 const ProcessFn &process) {
+    const auto inputs_expected{load_input_list(list_path)};
+    if (!inputs_expected.has_value())
+        return std::unexpected(inputs_expected.error());
+
+    const std::vector<std::string> &inputs{inputs_expected.value()};
+
+    const auto manifest{load_manifest(manifest_path)};
+
+    auto manifest_out_expected{open_manifest(manifest_path)};
+    if (!manifest_out_expected.has_value())
+        return std::unexpected(manifest_out_expected.error());
+
+    std::ofstream &manifest_out{manifest_out_expected.value()};
+
+    BatchStats stats{};
+
+    for (std::size_t k = shard.index; k < inputs.size(); k += shard.count) {
+        const std::string &input{inputs[k]};
+
+        if (is_done(manifest, input, config)) {
+            stats.skipped++;
+            continue;
+        }
+
+        const auto start{std::chrono::steady_clock::now()};
+        const auto output_expected{process(input, batch_output_name(input))};
+        const std::chrono::duration<double, std::milli> elapsed{std::chrono::steady_clock::now() - start};
+
+        if (!output_expected.has_value()) {
+            std::println(stderr, "Failed to process {}: {}", input, output_expected.error());
+            stats.failed++;
+            continue;
+        }
+
+        const auto checksum_expected{checksum_file(output_expected.value())};
+        if (!checksum_expected.has_value()) {
+            std::println(stderr, "Failed to checksum output of {}: {}", input, checksum_expected.error());
+            stats.failed++;
+            continue;
+        }
+
+        // Flushed per item; a pre-emption then costs at most the item in flight
+        manifest_out << std::format("{}\t{}\t{:016x}\t{}\t{:.3f}\n", input, output_expected.value(),
+                                    checksum_expected.value(), config, elapsed.count())
+                     << std::flush;
+
+        if (!manifest_out)
+            return std::unexpected("Failed to append to manifest: " + manifest_path);
+
+        stats.processed++;
+    }
+
+    return stats;
+}
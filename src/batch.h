@@ -0,0 +1,47 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <expected>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// The i-th of N disjoint slices of an input list; i is 0-based
+struct Shard {
+    int index;
+    int count;
+};
+
+struct BatchStats {
+    int processed;
+    int skipped; // Already in the manifest w/ an intact output
+    int failed;
+};
+
+// Parses "i/N", w/ 0 <= i < N
+std::expected<Shard, std::string> parse_shard(std::string_view spec);
+
+// Stem of the input plus a hash of its full path, so e.g. a/img.png & b/img.png never overwrite each other in a
+// shared output dir
+std::string batch_output_name(const std::string &input);
+
+// Short hash of a description of every setting that affects the outputs; a manifest entry made under another
+// fingerprint is stale
+std::string config_fingerprint(std::string_view config);
+
+// Processes one input, naming its outputs after `name`; returns the path of the edge map it wrote
+using ProcessFn =
+    std::function<std::expected<std::string, std::string>(const std::string &input, const std::string &name)>;
+
+// Runs `process` over this shard's slice of the input list at list_path (one path per line)
+// The list is sorted first, so every node agrees on the slicing w/o coordinating; item k belongs to shard k % N
+// Fails upfront if two inputs of the list would map to the same output name
+// Each completed item is appended to the manifest (input, output, output checksum, config fingerprint, time taken) as
+// soon as it's done; items whose manifest entry was made under the same config & still matches their output on disk
+// are skipped, which is what makes a re-run resume
+// Failed items are reported on stderr, left out of the manifest (so they're retried) and don't stop the batch
+std::expected<BatchStats, std::string> run_batch(const std::string &list_path, const Shard shard,
+                                                 const std::string &manifest_path, const std::string &config,
+                                                 const ProcessFn &process);
+
+#endif // BATCH_H
@@ -3,20 +3,65 @@
 #include <knr/hysteresis.h>
 #include <knr/io.h>
 #include <knr/nms.h>
+#include <knr/threshold.h>
+#include <knr/tune.h>
 #include <knr/utils.h>
 
-std::expected<cv::Mat, std::string> kd::canny_edge_detector(const std::string &img_name, const cv::Mat &img,
-                                                            const CannyCfg &cfg, bool save_intermediates) {
-    // --- G + Gx/Gy ---
+#include <algorithm>
+#include <atomic>
+#include <format>
+#include <string_view>
+
+namespace {
+
+// run_canny calls in flight, across threads; the autotuner holds off on persisting timings made alongside others
+std::atomic<int> runs_in_flight{};
+
+struct InFlight {
+    InFlight() { runs_in_flight.fetch_add(1); }
+    ~InFlight() { runs_in_flight.fetch_sub(1); }
+
+    InFlight(const InFlight &)            = delete;
+    InFlight &operator=(const InFlight &) = delete;
+};
+
+} // namespace
+
+std::expected<kd::CannyOutputs, std::string> kd::run_canny(const cv::Mat &img, const CannyCfg &cfg,
+                                                           const CannyStage outputs, const std::stop_token &stop) {
+    using enum CannyStage;
+
+    const InFlight in_flight{};
+
+    const auto cancelled = [](const std::string_view next_stage) -> std::unexpected<std::string> {
+        return std::unexpected{std::format("Cancelled before {}", next_stage)};
+    };
+
+    // --- Resolve the stages the requested outputs depend on ---
+    const bool needs_edges{has_stage(outputs, Edges)};
+    const bool needs_nms{needs_edges || has_stage(outputs, Nms)};
+    const bool needs_dir{needs_nms || has_stage(outputs, Direction)};
+    const bool needs_mag{needs_nms || has_stage(outputs, Magnitude)};
+    const bool needs_grad{needs_dir || needs_mag || has_stage(outputs, Gradients)};
+
+    CannyOutputs out{};
+
+    if (!needs_grad)
+        return out;
+
+    if (stop.stop_requested())
+        return cancelled("convolution");
+
+    // --- g'/g + Gx/Gy ---
     const int filt_size{compute_filter_size(cfg.sigma, cfg.T)};
 
-    const auto gaussian_filt_expected{generate_gaussian_filter(filt_size, cfg.sigma)};
-    if (!gaussian_filt_expected.has_value())
-        return std::unexpected{"Failed to generate gaussian filter: " + gaussian_filt_expected.error()};
+    const auto sep_expected{compute_separable_gaussian_derivatives(filt_size, cfg.sigma)};
+    if (!sep_expected.has_value())
+        return std::unexpected{"Failed to compute separable partial derivatives: " + sep_expected.error()};
 
-    const cv::Mat filt{gaussian_filt_expected.value()};
+    const std::pair<cv::Mat, cv::Mat> sep{sep_expected.value()};
 
-    const auto part_der_result_expected{compute_gaussian_derivatives(filt, cfg.sigma)};
+    const auto part_der_result_expected{compute_gaussian_derivatives(sep.first, sep.second)};
     if (!part_der_result_expected.has_value())
         return std::unexpected{"Failed to partial derivatives of Gaussian: " + part_der_result_expected.error()};
 
@@ -25,56 +70,140 @@ std::expected<cv::Mat, std::string> kd::canny_edge_detector(const std::string &i
     // --- Fx/Fy ---
     const cv::Mat img_padded{pad_image(img, gx.rows / 2)};
 
-    const auto fx_expected{convolve_through_image(img_padded, gx)};
+    ConvPlan plan{};
+    if (cfg.conv_plan.has_value()) {
+        plan = cfg.conv_plan.value();
+        if (cfg.max_threads > 0)
+            plan.threads = std::min(plan.threads, cfg.max_threads);
+    } else {
+        const auto plan_expected{select_conv_plan(img_padded, gx, sep, cfg.max_threads, cfg.tune_cache,
+                                                  runs_in_flight.load() > 1)};
+        if (!plan_expected.has_value())
+            return std::unexpected{"Failed to select convolution backend: " + plan_expected.error()};
+
+        plan = plan_expected.value();
+    }
+
+    const auto convolve = [&](const cv::Mat &fogd, const cv::Mat &kern_x, const cv::Mat &kern_y) {
+        return plan.backend == ConvBackend::Direct
+                   ? convolve_rescaled_through_image(img_padded, fogd, plan.threads)
+                   : convolve_separable_through_image(img_padded, kern_x, kern_y, plan.threads);
+    };
+
+    const auto fx_expected{convolve(gx, sep.first, sep.second)};
     if (!fx_expected.has_value())
         return std::unexpected{"Failed to compute image fx: " + fx_expected.error()};
 
     const cv::Mat fx{fx_expected.value()};
 
-    const auto fy_expected{convolve_through_image(img_padded, gy)};
+    const auto fy_expected{convolve(gy, sep.second, sep.first)};
 
     if (!fy_expected.has_value())
         return std::unexpected{"Failed to compute image fy: " + fy_expected.error()};
 
     const cv::Mat fy{fy_expected.value()};
 
+    if (has_stage(outputs, Gradients)) {
+        out.fx = fx;
+        out.fy = fy;
+    }
+
+    if (stop.stop_requested())
+        return cancelled("gradient direction/magnitude");
+
     // --- Gradient Direction ---
-    const auto grad_dir_expected{compute_gradient_direction(fx, fy)};
-    if (!grad_dir_expected.has_value())
-        return std::unexpected{"Failed to generate gradient directions: " + grad_dir_expected.error()};
+    cv::Mat grad_dir{};
+    if (needs_dir) {
+        const auto grad_dir_expected{compute_gradient_direction(fx, fy)};
+        if (!grad_dir_expected.has_value())
+            return std::unexpected{"Failed to generate gradient directions: " + grad_dir_expected.error()};
 
-    const cv::Mat grad_dir{grad_dir_expected.value()};
+        grad_dir = grad_dir_expected.value();
 
-    // --- Gradient Magnitude + Save ---
-    const auto grad_mag_expected{compute_gradient_magnitude(fx, fy)};
-    if (!grad_mag_expected.has_value())
-        return std::unexpected{"Failed to generate gradient magections: " + grad_mag_expected.error()};
+        if (has_stage(outputs, Direction))
+            out.direction = grad_dir;
+    }
 
-    const cv::Mat grad_mag{grad_mag_expected.value()};
+    // --- Gradient Magnitude ---
+    cv::Mat grad_mag{};
+    if (needs_mag) {
+        const auto grad_mag_expected{compute_gradient_magnitude(fx, fy)};
+        if (!grad_mag_expected.has_value())
+            return std::unexpected{"Failed to generate gradient magections: " + grad_mag_expected.error()};
 
-    if (save_intermediates) {
-        const auto mag_sv_expected{save_image(grad_mag, cfg.out_dir, img_name, "magnitude", cfg.sigma)};
-        if (!mag_sv_expected.has_value())
-            return std::unexpected{"Failed to save image grad_mag: " + mag_sv_expected.error()};
+        grad_mag = grad_mag_expected.value();
+
+        if (has_stage(outputs, Magnitude))
+            out.magnitude = grad_mag;
     }
 
-    // --- Non-Maximum Suppresion + Save ---
-    const auto nms_mag_expected{non_maximum_suppression(grad_mag, grad_dir)};
+    if (!needs_nms)
+        return out;
+
+    if (stop.stop_requested())
+        return cancelled("non-maximum suppression");
+
+    // --- Non-Maximum Suppresion ---
+    // The histogram of responses is tallied in the same pass, for auto thresholding
+    Histogram nms_hist{};
+    const auto nms_mag_expected{non_maximum_suppression(grad_mag, grad_dir, nms_hist)};
     if (!nms_mag_expected.has_value())
         return std::unexpected{"Failed to generate nms mat: " + nms_mag_expected.error()};
 
     const cv::Mat nms_mag{nms_mag_expected.value()};
 
-    if (save_intermediates) {
-        const auto nms_sv_expected{save_image(nms_mag, cfg.out_dir, img_name, "nms", cfg.sigma)};
-        if (!nms_sv_expected.has_value())
-            return std::unexpected{"Failed to save image nms: " + nms_sv_expected.error()};
+    if (has_stage(outputs, Nms))
+        out.nms = nms_mag;
+
+    if (!needs_edges)
+        return out;
+
+    if (stop.stop_requested())
+        return cancelled("hysteresis");
+
+    // --- Threshold Selection ---
+    Thresholds thresholds{cfg.low_threshold, cfg.high_threshold};
+    if (cfg.threshold_mode != ThresholdMode::Fixed) {
+        const auto thresholds_expected{select_thresholds(nms_hist, cfg.threshold_mode, cfg.threshold_percentile)};
+        if (!thresholds_expected.has_value())
+            return std::unexpected{"Failed to select thresholds: " + thresholds_expected.error()};
+
+        thresholds = thresholds_expected.value();
     }
 
-    // --- Hysteresis Thresholding + Save ---
-    const auto thresholded_mag_expected{apply_hysteresis(nms_mag, cfg.low_threshold, cfg.high_threshold)};
+    // --- Hysteresis Thresholding ---
+    const auto thresholded_mag_expected{apply_hysteresis(nms_mag, thresholds.low, thresholds.high)};
     if (!thresholded_mag_expected.has_value())
         return std::unexpected{"Failed to apply hysteresis thresholding: " + thresholded_mag_expected.error()};
 
-    return thresholded_mag_expected.value();
+    out.edges      = thresholded_mag_expected.value();
+    out.thresholds = thresholds;
+
+    return out;
+}
+
+std::expected<kd::CannyResult, std::string> kd::canny_edge_detector(const std::string &img_name, const cv::Mat &img,
+                                                                   const CannyCfg &cfg, bool save_intermediates) {
+    using enum CannyStage;
+
+    const CannyStage stages{save_intermediates ? Edges | Magnitude | Nms : Edges};
+
+    const auto outputs_expected{run_canny(img, cfg, stages)};
+    if (!outputs_expected.has_value())
+        return std::unexpected{outputs_expected.error()};
+
+    const CannyOutputs &outputs{outputs_expected.value()};
+
+    // --- Save Intermediates ---
+    if (save_intermediates) {
+        const auto mag_sv_expected{save_image(*outputs.magnitude, cfg.out_dir, img_name, "magnitude", cfg.sigma)};
+        if (!mag_sv_expected.has_value())
+            return std::unexpected{"Failed to save image grad_mag: " + mag_sv_expected.error()};
+
+        const auto nms_sv_expected{save_image(*outputs.nms, cfg.out_dir, img_name, "nms", cfg.sigma)};
+        if (!nms_sv_expected.has_value())
+            return std::unexpected{"Failed to save image nms: " + nms_sv_expected.error()};
+    }
+
+    return CannyResult{*outputs.edges, *outputs.thresholds};
 }
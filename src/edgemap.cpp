@@ -0,0 +1,185 @@
+#include <knr/edgemap.h>
+
+#include <opencv2/opencv.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace kd {
+
+namespace {
+
+// Skips whitespace & '#' comments, then parses a non-negative decimal; pos is left just past it
+std::expected<int, std::string> parse_header_int(const std::uint8_t *data, const std::size_t len, std::size_t &pos) {
+    while (pos < len && (std::isspace(data[pos]) || data[pos] == '#')) {
+        if (data[pos] == '#')
+            while (pos < len && data[pos] != '\n')
+                pos++;
+        else
+            pos++;
+    }
+
+    if (pos == len || !std::isdigit(data[pos]))
+        return std::unexpected("Malformed PBM header");
+
+    long value{};
+    while (pos < len && std::isdigit(data[pos])) {
+        value = value * 10 + (data[pos++] - '0');
+        if (value > std::numeric_limits<int>::max())
+            return std::unexpected("PBM dimensions out of range");
+    }
+
+    return static_cast<int>(value);
+}
+
+} // namespace
+
+std::expected<void, std::string> write_edge_map(const cv::Mat &edges, const std::string &path) {
+    if (edges.type() != CV_8UC1)
+        return std::unexpected("Expected edge map to be of type CV_8UC1");
+
+    const std::size_t stride{(static_cast<std::size_t>(edges.cols) + 7) / 8};
+    std::vector<std::uint8_t> bits(stride * edges.rows, 0);
+
+    for (int y = 0; y < edges.rows; y++) {
+        const auto *edges_row{edges.ptr<std::uint8_t>(y)};
+        auto *bits_row{bits.data() + y * stride};
+
+        for (int x = 0; x < edges.cols; x++)
+            if (edges_row[x] != 0)
+                bits_row[x / 8] |= 0x80 >> (x % 8);
+    }
+
+    // Write to a sibling & rename over, rather than truncating in place: readers that have the old file mapped keep
+    // their (now unlinked) copy instead of faulting w/ SIGBUS
+    const auto tmp_path{std::format("{}.{}", path, std::random_device{}())};
+
+    {
+        std::ofstream out{tmp_path, std::ios::binary};
+        out << std::format("P4\n{} {}\n", edges.cols, edges.rows);
+        out.write(reinterpret_cast<const char *>(bits.data()), static_cast<std::streamsize>(bits.size()));
+
+        if (!out) {
+            std::error_code e;
+            std::filesystem::remove(tmp_path, e);
+            return std::unexpected("Failed to write edge map: " + tmp_path);
+        }
+    }
+
+    std::error_code e;
+    std::filesystem::rename(tmp_path, path, e);
+    if (e) {
+        std::filesystem::remove(tmp_path, e);
+        return std::unexpected("Failed to replace edge map: " + path);
+    }
+
+    return {};
+}
+
+std::expected<MappedEdgeMap, std::string> MappedEdgeMap::open(const std::string &path) {
+    const int fd{::open(path.c_str(), O_RDONLY)};
+    if (fd < 0)
+        return std::unexpected("Failed to open edge map: " + path);
+
+    struct stat st{};
+    if (fstat(fd, &st) < 0 || st.st_size <= 0) {
+        close(fd);
+        return std::unexpected("Failed to stat (or empty) edge map: " + path);
+    }
+
+    const auto map_len{static_cast<std::size_t>(st.st_size)};
+    void *map{mmap(nullptr, map_len, PROT_READ, MAP_SHARED, fd, 0)};
+    close(fd); // The mapping outlives the descriptor
+
+    if (map == MAP_FAILED)
+        return std::unexpected("Failed to mmap edge map: " + path);
+
+    const auto *data{static_cast<const std::uint8_t *>(map)};
+
+    const auto fail = [&](const std::string &why) -> std::unexpected<std::string> {
+        munmap(map, map_len);
+        return std::unexpected{std::format("{}: {}", why, path)};
+    };
+
+    if (map_len < 2 || data[0] != 'P' || data[1] != '4')
+        return fail("Not a binary PBM (P4)");
+
+    std::size_t pos{2};
+
+    const auto cols_expected{parse_header_int(data, map_len, pos)};
+    if (!cols_expected.has_value())
+        return fail(cols_expected.error());
+
+    const auto rows_expected{parse_header_int(data, map_len, pos)};
+    if (!rows_expected.has_value())
+        return fail(rows_expected.error());
+
+    // Exactly one whitespace character separates the header from the bits
+    if (pos == map_len || !std::isspace(data[pos]))
+        return fail("Malformed PBM header");
+    pos++;
+
+    const int rows{rows_expected.value()};
+    const int cols{cols_expected.value()};
+    const std::size_t stride{(static_cast<std::size_t>(cols) + 7) / 8};
+
+    if (map_len - pos < stride * rows)
+        return fail(std::format("Truncated PBM, expected {}x{}", cols, rows));
+
+    return MappedEdgeMap{map, map_len, data + pos, rows, cols};
+}
+
+MappedEdgeMap::MappedEdgeMap(void *map, const std::size_t map_len, const std::uint8_t *bits, const int rows,
+                             const int cols)
+    : map_{map}, map_len_{map_len}, bits_{bits}, rows_{rows}, cols_{cols} {}
+
+MappedEdgeMap::~MappedEdgeMap() {
+    if (map_ != nullptr)
+        munmap(map_, map_len_);
+}
+
+MappedEdgeMap::MappedEdgeMap(MappedEdgeMap &&other) noexcept
+    : map_{std::exchange(other.map_, nullptr)}, map_len_{std::exchange(other.map_len_, 0)},
+      bits_{std::exchange(other.bits_, nullptr)}, rows_{std::exchange(other.rows_, 0)},
+      cols_{std::exchange(other.cols_, 0)} {}
+
+MappedEdgeMap &MappedEdgeMap::operator=(MappedEdgeMap &&other) noexcept {
+    if (this != &other) {
+        if (map_ != nullptr)
+            munmap(map_, map_len_);
+
+        map_     = std::exchange(other.map_, nullptr);
+        map_len_ = std::exchange(other.map_len_, 0);
+        bits_    = std::exchange(other.bits_, nullptr);
+        rows_    = std::exchange(other.rows_, 0);
+        cols_    = std::exchange(other.cols_, 0);
+    }
+
+    return *this;
+}
+
+cv::Mat MappedEdgeMap::unpack() const {
+    cv::Mat edges{rows_, cols_, CV_8UC1, cv::Scalar::all(0)};
+
+    for (int y = 0; y < rows_; y++) {
+        auto *edges_row{edges.ptr<std::uint8_t>(y)};
+        for (int x = 0; x < cols_; x++)
+            if (at(y, x))
+                edges_row[x] = 255;
+    }
+
+    return edges;
+}
+
+} // namespace kd
@@ -0,0 +1,68 @@
+#include <knr/executor.h>
+
+#include <algorithm>
+#include <format>
+
+namespace kd {
+
+Executor::Executor(const unsigned workers, const std::size_t capacity) : capacity_{capacity} {
+    queue_.reserve(capacity_);
+
+    workers_.reserve(std::max(workers, 1u));
+    for (unsigned i = 0; i < std::max(workers, 1u); i++)
+        workers_.emplace_back([this](std::stop_token stop) { work(stop); });
+}
+
+Executor::~Executor() {
+    for (auto &w : workers_)
+        w.request_stop();
+
+    workers_.clear();
+}
+
+std::expected<void, std::string> Executor::submit(std::move_only_function<void()> job, const Priority prio) {
+    {
+        const std::lock_guard lock{mtx_};
+
+        if (queue_.size() >= capacity_)
+            return std::unexpected(std::format("Executor queue is full ({} jobs)", capacity_));
+
+        queue_.emplace_back(prio, next_seq_++, std::move(job));
+        std::ranges::push_heap(queue_, runs_after);
+    }
+
+    cv_.notify_one();
+    return {};
+}
+
+bool Executor::runs_after(const Job &a, const Job &b) {
+    if (a.prio != b.prio)
+        return a.prio < b.prio;
+
+    return a.seq > b.seq;
+}
+
+void Executor::work(std::stop_token stop) {
+    while (true) {
+        std::unique_lock lock{mtx_};
+        cv_.wait(lock, stop, [this] { return !queue_.empty(); });
+
+        // Only empty once a stop was requested & everything queued has been handed out
+        if (queue_.empty())
+            return;
+
+        std::ranges::pop_heap(queue_, runs_after);
+        auto job{std::move(queue_.back())};
+        queue_.pop_back();
+        lock.unlock();
+
+        job.fn();
+    }
+}
+
+Executor &default_executor() {
+    static Executor executor{std::thread::hardware_concurrency(), 1024};
+    return executor;
+}
+
+} // namespace kd
@@ -1,15 +1,79 @@
 #include <knr/gauss.h>
 
+#include <knr/utils.h>
+
 #include <opencv2/opencv.hpp>
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <format>
 #include <numeric>
 #include <span>
+#include <vector>
 
 namespace kd {
 
+namespace {
+
+constexpr float factor_scale{256}; // 1D factors are quantized at 2^8, so the 2D FOGD (their product) is at 2^16
+constexpr int output_shift{8};     // fx/fy are brought back down to 2^8, the scale the rest of the pipeline expects
+
+// Shared by both backends so they round identically
+constexpr std::int32_t rescale(const std::int32_t acc) { return (acc + (1 << (output_shift - 1))) >> output_shift; }
+
+// Direct 2D convolution; sums are kept as is, or rounded down from 2^16 to 2^8 if rescaled
+std::expected<cv::Mat, std::string> convolve_fogd(const cv::Mat &img_padded, const cv::Mat &fogd, const int threads,
+                                                  const bool rescaled) {
+    if (img_padded.type() != CV_8UC1)
+        return std::unexpected("Unexpected image type; require CV_8UC1 (grayscale).");
+
+    if (fogd.type() != CV_16SC1)
+        return std::unexpected("Unexpected partial derivative type; require CV_16SC1.");
+
+    // NOTE: accounts for padding!
+    const int fogd_size{fogd.rows};
+    if (fogd_size > img_padded.rows || fogd_size > img_padded.cols)
+        return std::unexpected(
+            std::format("FOGD size {} can't exceed image res {}x{}.", fogd_size, img_padded.rows, img_padded.cols));
+
+    const int half_size{fogd.rows / 2};
+
+    cv::Mat f_part{};
+    f_part.create(img_padded.rows - (fogd.rows - 1), img_padded.cols - (fogd.cols - 1), CV_32SC1);
+
+    std::span<std::int16_t> fogd_flat{reinterpret_cast<std::int16_t *>(fogd.data),
+                                      reinterpret_cast<std::int16_t *>(fogd.data + fogd.elemSize() * fogd.total())};
+
+    parallel_for_rows(half_size, img_padded.rows - half_size, threads, [&](const int y_begin, const int y_end) {
+        std::vector<uint8_t> patch{};
+        patch.reserve(fogd.rows * fogd.cols);
+
+        for (int y = y_begin; y < y_end; y++) {
+
+            auto *f_row{f_part.ptr<std::int32_t>(y - half_size)};
+
+            for (int x = half_size; x < img_padded.cols - half_size; x++) {
+
+                // Populate patch
+                for (int yy = y - half_size; yy <= y + half_size; yy++) {
+                    const auto *padded_row{img_padded.ptr<std::uint8_t>(yy)};
+                    for (int xx = x - half_size; xx <= x + half_size; xx++)
+                        patch.emplace_back(padded_row[xx]);
+                }
+
+                const std::int32_t dot_prod{std::inner_product(patch.begin(), patch.end(), fogd_flat.begin(), 0)};
+                f_row[x - half_size] = rescaled ? rescale(dot_prod) : dot_prod;
+                patch.clear();
+            }
+        }
+    });
+
+    return f_part;
+}
+
+} // namespace
+
 int compute_filter_size(float sigma, float T) {
     const int half_size{static_cast<int>(std::round(sqrt(-std::logf(T)) * 2 * sigma * sigma))};
     return 2 * half_size + 1;
@@ -102,48 +166,155 @@ std::expected<std::pair<cv::Mat, cv::Mat>, std::string> compute_gaussian_derivat
     return std::pair{gx_i16, gy_i16};
 }
 
-std::expected<cv::Mat, std::string> convolve_through_image(const cv::Mat &img_padded, const cv::Mat &fogd) {
+std::expected<std::pair<cv::Mat, cv::Mat>, std::string> compute_separable_gaussian_derivatives(const int filter_size,
+                                                                                               const float sigma) {
+    if (sigma < 0.5)
+        return std::unexpected(std::format("Small sigma, expected sigma >= 0.5: {}", sigma));
+
+    if (filter_size < 0 || filter_size % 2 == 0)
+        return std::unexpected(std::format("Filter size should be +ve & odd: {}", filter_size));
+
+    std::vector<float> g_f(filter_size);
+
+    const float two_sigma_sq{2 * sigma * sigma};
+    const float inv_sigma_sq{1 / sigma * sigma};
+    const int half_size{filter_size / 2};
+
+    float sum{};
+    for (int x = 0; x < filter_size; x++) {
+        const int dx{x - half_size};
+        g_f[x] = exp(-(dx * dx) / two_sigma_sq);
+        sum += g_f[x];
+    }
+
+    // Normalize; g(x) * g(y) is then generate_gaussian_filter's G, up to the quantization below
+    for (auto &w : g_f)
+        w /= sum;
+
+    // Convert g' & g to int
+    cv::Mat dg_i16{};
+    cv::Mat g_i16{};
+    dg_i16.create(1, filter_size, CV_16SC1);
+    g_i16.create(1, filter_size, CV_16SC1);
+
+    auto *dg_row{dg_i16.ptr<std::int16_t>(0)};
+    auto *g_row{g_i16.ptr<std::int16_t>(0)};
+
+    for (int x = 0; x < filter_size; x++) {
+        const int dx{x - half_size};
+        g_row[x]  = static_cast<std::int16_t>(std::round(g_f[x] * factor_scale));
+        dg_row[x] = static_cast<std::int16_t>(std::round(-dx * inv_sigma_sq * g_f[x] * factor_scale));
+    }
+
+    return std::pair{dg_i16, g_i16};
+}
+
+std::expected<std::pair<cv::Mat, cv::Mat>, std::string> compute_gaussian_derivatives(const cv::Mat &dg,
+                                                                                     const cv::Mat &g) {
+    if (dg.type() != CV_16SC1 || g.type() != CV_16SC1)
+        return std::unexpected("1D factors were not of type CV_16SC1");
+
+    if (dg.rows != 1 || g.rows != 1 || dg.cols != g.cols)
+        return std::unexpected(std::format("1D factors should both be 1xN: 1x{} & 1x{}", dg.cols, g.cols));
+
+    const int filter_size{g.cols};
+
+    cv::Mat gx_i16{};
+    cv::Mat gy_i16{};
+    gx_i16.create(filter_size, filter_size, CV_16SC1);
+    gy_i16.create(filter_size, filter_size, CV_16SC1);
+
+    const auto *dg_row{dg.ptr<std::int16_t>(0)};
+    const auto *g_row{g.ptr<std::int16_t>(0)};
+
+    // |g'| <= 256 * 0.25 & g <= 256 * 0.8 for sigma >= 0.5, so products fit in 16 bits
+    for (int y = 0; y < filter_size; y++) {
+        auto *gx_i16_row{gx_i16.ptr<std::int16_t>(y)};
+        auto *gy_i16_row{gy_i16.ptr<std::int16_t>(y)};
+
+        for (int x = 0; x < filter_size; x++) {
+            gx_i16_row[x] = static_cast<std::int16_t>(dg_row[x] * g_row[y]);
+            gy_i16_row[x] = static_cast<std::int16_t>(g_row[x] * dg_row[y]);
+        }
+    }
+
+    return std::pair{gx_i16, gy_i16};
+}
+
+std::expected<cv::Mat, std::string> convolve_through_image(const cv::Mat &img_padded, const cv::Mat &fogd,
+                                                           const int threads) {
+    return convolve_fogd(img_padded, fogd, threads, false);
+}
+
+std::expected<cv::Mat, std::string> convolve_rescaled_through_image(const cv::Mat &img_padded, const cv::Mat &fogd,
+                                                                    const int threads) {
+    return convolve_fogd(img_padded, fogd, threads, true);
+}
+
+std::expected<cv::Mat, std::string> convolve_separable_through_image(const cv::Mat &img_padded, const cv::Mat &kern_x,
+                                                                     const cv::Mat &kern_y, const int threads) {
     if (img_padded.type() != CV_8UC1)
         return std::unexpected("Unexpected image type; require CV_8UC1 (grayscale).");
 
-    if (fogd.type() != CV_16SC1)
-        return std::unexpected("Unexpected partial derivative type; require CV_16SC1.");
+    if (kern_x.type() != CV_16SC1 || kern_y.type() != CV_16SC1)
+        return std::unexpected("Unexpected separable kernel type; require CV_16SC1.");
+
+    if (kern_x.rows != 1 || kern_y.rows != 1 || kern_x.cols != kern_y.cols || kern_x.cols % 2 == 0)
+        return std::unexpected(std::format("Separable kernels should be 1xN w/ the same odd N: 1x{} & 1x{}",
+                                           kern_x.cols, kern_y.cols));
 
     // NOTE: accounts for padding!
-    const int fogd_size{fogd.rows};
-    if (fogd_size > img_padded.rows || fogd_size > img_padded.cols)
+    const int kern_size{kern_x.cols};
+    if (kern_size > img_padded.rows || kern_size > img_padded.cols)
         return std::unexpected(
-            std::format("FOGD size {} can't exceed image res {}x{}.", fogd_size, img_padded.rows, img_padded.cols));
+            std::format("Kernel size {} can't exceed image res {}x{}.", kern_size, img_padded.rows, img_padded.cols));
 
-    const int half_size{fogd.rows / 2};
+    const int out_rows{img_padded.rows - (kern_size - 1)};
+    const int out_cols{img_padded.cols - (kern_size - 1)};
 
-    cv::Mat f_part{};
-    f_part.create(img_padded.rows - (fogd.rows - 1), img_padded.cols - (fogd.cols - 1), CV_32SC1);
+    const auto *kx{kern_x.ptr<std::int16_t>(0)};
+    const auto *ky{kern_y.ptr<std::int16_t>(0)};
 
-    std::vector<uint8_t> patch{};
-    patch.reserve(fogd.rows * fogd.cols);
+    // Horizontal pass, over every padded row as the vertical pass needs them
+    // Integer all the way through, so sums are exact & equal the direct backend's
+    cv::Mat tmp{};
+    tmp.create(img_padded.rows, out_cols, CV_32SC1);
 
-    std::span<std::int16_t> fogd_flat{reinterpret_cast<std::int16_t *>(fogd.data),
-                                      reinterpret_cast<std::int16_t *>(fogd.data + fogd.elemSize() * fogd.total())};
+    parallel_for_rows(0, img_padded.rows, threads, [&](const int y_begin, const int y_end) {
+        for (int y = y_begin; y < y_end; y++) {
+            const auto *padded_row{img_padded.ptr<std::uint8_t>(y)};
+            auto *tmp_row{tmp.ptr<std::int32_t>(y)};
 
-    for (int y = half_size; y < img_padded.rows - half_size; y++) {
+            for (int x = 0; x < out_cols; x++) {
+                std::int32_t acc{};
+                for (int k = 0; k < kern_size; k++)
+                    acc += padded_row[x + k] * kx[k];
+                tmp_row[x] = acc;
+            }
+        }
+    });
 
-        auto *f_row{f_part.ptr<std::int32_t>(y - half_size)};
+    // Vertical pass, accumulating whole rows at a time to stay cache-friendly
+    cv::Mat f_part{};
+    f_part.create(out_rows, out_cols, CV_32SC1);
 
-        for (int x = half_size; x < img_padded.cols - half_size; x++) {
+    parallel_for_rows(0, out_rows, threads, [&](const int y_begin, const int y_end) {
+        std::vector<std::int32_t> acc(out_cols);
 
-            // Populate patch
-            for (int yy = y - half_size; yy <= y + half_size; yy++) {
-                const auto *padded_row{img_padded.ptr<std::uint8_t>(yy)};
-                for (int xx = x - half_size; xx <= x + half_size; xx++)
-                    patch.emplace_back(padded_row[xx]);
+        for (int y = y_begin; y < y_end; y++) {
+            std::ranges::fill(acc, 0);
+
+            for (int k = 0; k < kern_size; k++) {
+                const auto *tmp_row{tmp.ptr<std::int32_t>(y + k)};
+                for (int x = 0; x < out_cols; x++)
+                    acc[x] += tmp_row[x] * ky[k];
             }
 
-            const std::int32_t dot_prod{std::inner_product(patch.begin(), patch.end(), fogd_flat.begin(), 0)};
-            f_row[x - half_size] = dot_prod;
-            patch.clear();
+            auto *f_row{f_part.ptr<std::int32_t>(y)};
+            for (int x = 0; x < out_cols; x++)
+                f_row[x] = rescale(acc[x]);
         }
-    }
+    });
 
     return f_part;
 }
@@ -1,8 +1,32 @@
+#include <knr/edgemap.h>
 #include <knr/io.h>
 
 #include <filesystem>
+#include <format>
 
 namespace kd {
+
+std::string_view to_string(const EdgeFormat format) {
+    switch (format) {
+    case EdgeFormat::Jpg:
+        return "jpg";
+    case EdgeFormat::Pbm:
+        return "pbm";
+    }
+
+    return "invalid";
+}
+
+std::expected<EdgeFormat, std::string> parse_edge_format(std::string_view name) {
+    if (name == "jpg")
+        return EdgeFormat::Jpg;
+
+    if (name == "pbm")
+        return EdgeFormat::Pbm;
+
+    return std::unexpected(std::format("Unknown edge map format: {}", name));
+}
+
 std::expected<cv::Mat, std::string> load_image(const std::string &path) {
     cv::Mat img{cv::imread(path, cv::IMREAD_GRAYSCALE)};
 
@@ -12,18 +36,43 @@ std::expected<cv::Mat, std::string> load_image(const std::string &path) {
     return img;
 }
 
-std::expected<void, std::string> save_image(const cv::Mat &img, const std::string &out_dir, const std::string &img_name,
-                                            const std::string &phase, const float sigma) {
+static std::expected<void, std::string> ensure_dir(const std::string &out_dir) {
     if (!std::filesystem::exists(out_dir)) {
         std::error_code e;
         if (!std::filesystem::create_directories(out_dir, e))
             return std::unexpected("Failed to create directory: " + e.message());
     }
 
+    return {};
+}
+
+std::expected<std::string, std::string> save_image(const cv::Mat &img, const std::string &out_dir,
+                                                   const std::string &img_name, const std::string &phase,
+                                                   const float sigma) {
+    const auto dir_expected{ensure_dir(out_dir)};
+    if (!dir_expected.has_value())
+        return std::unexpected(dir_expected.error());
+
     auto fname{std::format("{}/{}_{}_{}.jpg", out_dir, img_name, phase, sigma)};
-    // TODO: handle imwrite errors
-    cv::imwrite(fname, img);
+    if (!cv::imwrite(fname, img))
+        return std::unexpected("Failed to write image: " + fname);
 
-    return {};
+    return fname;
+}
+
+std::expected<std::string, std::string> save_edge_map(const cv::Mat &edges, const std::string &out_dir,
+                                                      const std::string &img_name, const std::string &phase,
+                                                      const float sigma) {
+    const auto dir_expected{ensure_dir(out_dir)};
+    if (!dir_expected.has_value())
+        return std::unexpected(dir_expected.error());
+
+    auto fname{std::format("{}/{}_{}_{}.pbm", out_dir, img_name, phase, sigma)};
+
+    const auto write_expected{write_edge_map(edges, fname)};
+    if (!write_expected.has_value())
+        return std::unexpected(write_expected.error());
+
+    return fname;
 }
 } // namespace kd
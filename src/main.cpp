@@ -1,13 +1,83 @@
 #include "args.h"
+#include "batch.h"
 
 #include <knr/canny.h>
 #include <knr/io.h>
+#include <knr/pyramid.h>
 #include <opencv2/opencv.hpp>
 
 #include <cstdlib>
 #include <filesystem>
 #include <print>
 
+// Runs the detector over one image & saves the edge map (& intermediates) named after img_name, returning its path
+static std::expected<std::string, std::string> process_image(const std::string &img_path, const std::string &img_name,
+                                                             const ArgConfig &args) {
+    // --- Load image ---
+    const auto img_expected{kd::load_image(img_path)};
+    if (!img_expected.has_value())
+        return std::unexpected("Failed to load image: " + img_expected.error());
+
+    const cv::Mat img{img_expected.value()};
+
+    // --- Canny ---
+    const kd::CannyCfg cfg{
+        .sigma                = args.sigma,
+        .T                    = args.T,
+        .low_threshold        = args.low_threshold,
+        .high_threshold       = args.high_threshold,
+        .out_dir              = args.out_dir,
+        .conv_plan            = args.conv_plan,
+        .tune_cache           = args.tune_cache,
+        .threshold_mode       = args.threshold_mode,
+        .threshold_percentile = args.threshold_percentile,
+    };
+
+    cv::Mat thresh_mag{};
+    std::string hyst_phase_name{};
+
+    if (args.levels == 1) {
+        const auto canny_expected{kd::canny_edge_detector(img_name, img, cfg, true)};
+        if (!canny_expected.has_value())
+            return std::unexpected("Failed to run canny: " + canny_expected.error());
+
+        const auto [edges, thresholds]{canny_expected.value()};
+
+        if (args.threshold_mode != kd::ThresholdMode::Fixed)
+            std::println("{}: {} thresholds: low = {}, high = {}", img_name, kd::to_string(args.threshold_mode),
+                         thresholds.low, thresholds.high);
+
+        thresh_mag      = edges;
+        hyst_phase_name = std::format("hysteresis_{}_{}", thresholds.low, thresholds.high);
+    } else {
+        const auto multiscale_expected{kd::multiscale_canny(img_name, img, cfg, args.levels, args.combine, true)};
+        if (!multiscale_expected.has_value())
+            return std::unexpected("Failed to run multi-scale canny: " + multiscale_expected.error());
+
+        const auto [edges, thresholds]{multiscale_expected.value()};
+
+        if (args.threshold_mode != kd::ThresholdMode::Fixed)
+            for (std::size_t l = 0; l < thresholds.size(); l++)
+                std::println("{}: level {}: {} thresholds: low = {}, high = {}", img_name, l,
+                             kd::to_string(args.threshold_mode), thresholds[l].low, thresholds[l].high);
+
+        // Named after the finest level's thresholds
+        thresh_mag      = edges;
+        hyst_phase_name = std::format("hysteresis_{}_{}_{}{}", thresholds.front().low, thresholds.front().high,
+                                      kd::to_string(args.combine), thresholds.size());
+    }
+
+    // --- Save image ---
+    const auto thresh_mag_save_expected{
+        args.edge_format == kd::EdgeFormat::Pbm
+            ? kd::save_edge_map(thresh_mag, args.out_dir, img_name, hyst_phase_name, args.sigma)
+            : kd::save_image(thresh_mag, args.out_dir, img_name, hyst_phase_name, args.sigma)};
+    if (!thresh_mag_save_expected.has_value())
+        return std::unexpected("Failed to save edge detection image: " + thresh_mag_save_expected.error());
+
+    return thresh_mag_save_expected.value();
+}
+
 int main(int argc, char *argv[]) {
     // --- Config ---
     const auto args_expected = parse_args(argc, argv);
@@ -17,33 +87,30 @@ int main(int argc, char *argv[]) {
     }
     const ArgConfig args{args_expected.value()};
 
-    const std::string img_name{std::filesystem::path{args.img_path}.stem()};
+    // --- Single image ---
+    if (args.batch_list.empty()) {
+        const auto output_expected{process_image(args.img_path, std::filesystem::path{args.img_path}.stem(), args)};
+        if (!output_expected.has_value()) {
+            std::println(stderr, "{}", output_expected.error());
+            return EXIT_FAILURE;
+        }
 
-    // --- Load image ---
-    const auto img_expected{kd::load_image(args.img_path)};
-    if (!img_expected.has_value()) {
-        std::println(stderr, "Failed to load image: {}", img_expected.error());
-        return EXIT_FAILURE;
+        return EXIT_SUCCESS;
     }
-    const cv::Mat img{img_expected.value()};
 
-    // --- Canny ---
-    const auto thresh_mag_expected{kd::canny_edge_detector(
-        img_name, img, {args.sigma, args.T, args.low_threshold, args.high_threshold, args.out_dir}, true)};
-    if (!thresh_mag_expected.has_value()) {
-        std::println(stderr, "Failed to run canny: {}", thresh_mag_expected.error());
+    // --- Batch ---
+    const auto stats_expected{run_batch(args.batch_list, args.shard, args.manifest, args.config,
+                                        [&args](const std::string &input, const std::string &name) {
+                                            return process_image(input, name, args);
+                                        })};
+    if (!stats_expected.has_value()) {
+        std::println(stderr, "Failed to run batch: {}", stats_expected.error());
         return EXIT_FAILURE;
     }
-    const cv::Mat thresh_mag{thresh_mag_expected.value()};
+    const BatchStats stats{stats_expected.value()};
 
-    // --- Save image ---
-    const auto hyst_phase_name{std::format("hysteresis_{}_{}", args.low_threshold, args.high_threshold)};
-    const auto thresh_mag_save_expected{
-        kd::save_image(thresh_mag, args.out_dir, img_name, hyst_phase_name, args.sigma)};
-    if (!thresh_mag_save_expected.has_value()) {
-        std::println(stderr, "Failed to save edge detection image: {}", thresh_mag_save_expected.error());
-        return EXIT_FAILURE;
-    }
+    std::println("shard {}/{}: {} processed, {} skipped, {} failed", args.shard.index, args.shard.count,
+                 stats.processed, stats.skipped, stats.failed);
 
-    return EXIT_SUCCESS;
+    return stats.failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
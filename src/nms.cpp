@@ -6,8 +6,12 @@
 #include <cstdint>
 
 std::expected<cv::Mat, std::string> kd::non_maximum_suppression(const cv::Mat &grad_mag, const cv::Mat &grad_dir) {
-    using enum GradientDir;
+    Histogram hist{};
+    return non_maximum_suppression(grad_mag, grad_dir, hist);
+}
 
+std::expected<cv::Mat, std::string> kd::non_maximum_suppression(const cv::Mat &grad_mag, const cv::Mat &grad_dir,
+                                                                Histogram &hist) {
     if (grad_mag.type() != CV_8UC1)
         return std::unexpected("Input magnitude matrix is not 8UC1");
 
@@ -16,6 +20,7 @@ std::expected<cv::Mat, std::string> kd::non_maximum_suppression(const cv::Mat &g
 
     const cv::Mat padded_mag{pad_image(grad_mag, 1)};
     cv::Mat nms_mag{grad_mag.size(), grad_mag.type(), cv::Scalar::all(0)};
+    hist.fill(0);
 
     const int rows{nms_mag.rows};
     const int cols{nms_mag.cols};
@@ -24,28 +29,13 @@ std::expected<cv::Mat, std::string> kd::non_maximum_suppression(const cv::Mat &g
         for (int x = 1; x < cols - 1; x++) {
             const auto dir{grad_dir.at<std::uint8_t>(y - 1, x - 1)};
 
-            Px n1{}, n2{};
-
-            switch (static_cast<GradientDir>(dir)) {
-            case E_W:
-                n1 = {y, x - 1};
-                n2 = {y, x + 1};
-                break;
-            case NE_SW:
-                n1 = {y - 1, x - 1};
-                n2 = {y + 1, x + 1};
-                break;
-            case N_S:
-                n1 = {y - 1, x};
-                n2 = {y + 1, x};
-                break;
-            case NW_SE:
-                n1 = {y - 1, x + 1};
-                n2 = {y + 1, x - 1};
-                break;
-            default:
+            const auto step{gradient_step(static_cast<GradientDir>(dir))};
+            if (!step.has_value())
                 return std::unexpected("Gradient direction matrix had unexpected value: {}");
-            }
+
+            const auto [dy, dx]{step.value()};
+            const Px n1{y - dy, x - dx};
+            const Px n2{y + dy, x + dx};
 
             auto mag_at_px = [padded_mag](Px p) -> std::uint8_t {
                 return padded_mag.at<std::uint8_t>(p.first, p.second);
@@ -53,8 +43,10 @@ std::expected<cv::Mat, std::string> kd::non_maximum_suppression(const cv::Mat &g
 
             const auto curr_mag{mag_at_px({y, x})};
 
-            if (curr_mag > mag_at_px(n1) && curr_mag > mag_at_px(n2))
+            if (curr_mag > mag_at_px(n1) && curr_mag > mag_at_px(n2)) {
                 nms_mag.at<std::uint8_t>(y - 1, x - 1) = curr_mag;
+                hist[curr_mag]++;
+            }
         }
     }
 
@@ -0,0 +1,298 @@
+#include <knr/io.h>
+#include <knr/pyramid.h>
+#include <knr/utils.h>
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <format>
+
+namespace kd {
+
+namespace {
+
+constexpr std::array<std::uint16_t, 5> binomial{1, 4, 6, 4, 1};
+constexpr int min_level_side{16};
+
+// A coarse edge's band on the next finer level is up to 4px wide, so candidates in it are at most 3px apart
+constexpr int ridge_reach{3};
+
+// Whether (y, x) peaks along its gradient direction; unlike NMS, ties are broken towards one side rather than dropping
+// both pixels, so a plateau (e.g. a blurred edge's flat 8 bit response) still yields a 1px ridge
+bool is_ridge(const cv::Mat &mag, const cv::Mat &dir, const int y, const int x) {
+    if (y < 1 || x < 1 || y >= mag.rows - 1 || x >= mag.cols - 1)
+        return false;
+
+    const auto step{gradient_step(static_cast<GradientDir>(dir.at<std::uint8_t>(y, x)))};
+    if (!step.has_value())
+        return false;
+
+    const auto [dy, dx]{step.value()};
+    const auto curr_mag{mag.at<std::uint8_t>(y, x)};
+
+    return curr_mag > mag.at<std::uint8_t>(y - dy, x - dx) && curr_mag >= mag.at<std::uint8_t>(y + dy, x + dx);
+}
+
+// Carries the edges of `coarse` (half the resolution) down onto the fine level: every fine pixel w/ a coarse edge
+// within a pixel of it is kept if it's a fine edge (confirmed) or, failing that, the strongest ridge across the edge
+// within that band; the latter localizes coarse-only edges, too blurred to pass the fine level's thresholds, to where
+// the fine gradient peaks, w/o weaker parallel ridges (e.g. texture next to the edge) doubling them up
+cv::Mat confirm_edges(const cv::Mat &fine_edges, const cv::Mat &fine_mag, const cv::Mat &fine_dir,
+                      const cv::Mat &coarse) {
+    // --- Band: the strongest coarse edge within a pixel of every fine pixel ---
+    cv::Mat band{fine_edges.size(), CV_8UC1, cv::Scalar::all(0)};
+
+    for (int y = 0; y < band.rows; y++) {
+        auto *band_row{band.ptr<std::uint8_t>(y)};
+
+        // Coarse rows/cols covering the 3x3 neighbourhood of a fine pixel
+        const int cy_lo{std::max(y - 1, 0) / 2};
+        const int cy_hi{std::min((y + 1) / 2, coarse.rows - 1)};
+
+        for (int x = 0; x < band.cols; x++) {
+            const int cx_lo{std::max(x - 1, 0) / 2};
+            const int cx_hi{std::min((x + 1) / 2, coarse.cols - 1)};
+
+            for (int cy = cy_lo; cy <= cy_hi; cy++) {
+                const auto *coarse_row{coarse.ptr<std::uint8_t>(cy)};
+                for (int cx = cx_lo; cx <= cx_hi; cx++)
+                    band_row[x] = std::max(band_row[x], coarse_row[cx]);
+            }
+        }
+    }
+
+    // --- Candidates: fine edges & ridge pixels in the band ---
+    cv::Mat candidate{fine_edges.size(), CV_8UC1, cv::Scalar::all(0)};
+
+    for (int y = 0; y < band.rows; y++) {
+        const auto *band_row{band.ptr<std::uint8_t>(y)};
+        const auto *edges_row{fine_edges.ptr<std::uint8_t>(y)};
+        auto *candidate_row{candidate.ptr<std::uint8_t>(y)};
+
+        for (int x = 0; x < band.cols; x++)
+            candidate_row[x] = band_row[x] != 0 && (edges_row[x] != 0 || is_ridge(fine_mag, fine_dir, y, x));
+    }
+
+    // --- Keep fine edges, & ridge pixels no other candidate across the edge beats ---
+    cv::Mat confirmed{fine_edges.size(), CV_8UC1, cv::Scalar::all(0)};
+
+    const auto strongest = [&](const int y, const int x) {
+        const auto [dy, dx]{gradient_step(static_cast<GradientDir>(fine_dir.at<std::uint8_t>(y, x))).value()};
+        const auto curr_mag{fine_mag.at<std::uint8_t>(y, x)};
+
+        for (int k = 1; k <= ridge_reach; k++) {
+            for (const int side : {-1, 1}) {
+                const int yy{y + side * k * dy};
+                const int xx{x + side * k * dx};
+                if (yy < 0 || xx < 0 || yy >= fine_mag.rows || xx >= fine_mag.cols)
+                    continue;
+
+                if (!candidate.at<std::uint8_t>(yy, xx))
+                    continue;
+
+                // Ties go to the candidate before
+                const auto other_mag{fine_mag.at<std::uint8_t>(yy, xx)};
+                if (other_mag > curr_mag || (other_mag == curr_mag && side < 0))
+                    return false;
+            }
+        }
+
+        return true;
+    };
+
+    for (int y = 0; y < band.rows; y++) {
+        const auto *band_row{band.ptr<std::uint8_t>(y)};
+        const auto *edges_row{fine_edges.ptr<std::uint8_t>(y)};
+        const auto *candidate_row{candidate.ptr<std::uint8_t>(y)};
+        auto *confirmed_row{confirmed.ptr<std::uint8_t>(y)};
+
+        // Fine edges keep their strength; a localized coarse one takes the coarse level's, as its fine response may be
+        // faint
+        for (int x = 0; x < band.cols; x++) {
+            if (!candidate_row[x])
+                continue;
+
+            if (edges_row[x] != 0)
+                confirmed_row[x] = edges_row[x];
+            else if (strongest(y, x))
+                confirmed_row[x] = band_row[x];
+        }
+    }
+
+    return confirmed;
+}
+
+// Folds `coarse` (downscaled by 2^level) into `acc`, w/ nearest neighbour upsampling
+void union_edges(cv::Mat &acc, const cv::Mat &coarse, const int level) {
+    for (int y = 0; y < acc.rows; y++) {
+        const auto *coarse_row{coarse.ptr<std::uint8_t>(std::min(y >> level, coarse.rows - 1))};
+        auto *acc_row{acc.ptr<std::uint8_t>(y)};
+
+        for (int x = 0; x < acc.cols; x++)
+            acc_row[x] = std::max(acc_row[x], coarse_row[std::min(x >> level, coarse.cols - 1)]);
+    }
+}
+
+} // namespace
+
+std::string_view to_string(const ScaleCombine combine) {
+    switch (combine) {
+    case ScaleCombine::CoarseToFine:
+        return "confirm";
+    case ScaleCombine::Union:
+        return "union";
+    }
+
+    return "invalid";
+}
+
+std::expected<ScaleCombine, std::string> parse_scale_combine(std::string_view name) {
+    if (name == "confirm")
+        return ScaleCombine::CoarseToFine;
+
+    if (name == "union")
+        return ScaleCombine::Union;
+
+    return std::unexpected(std::format("Unknown scale combination: {}", name));
+}
+
+std::expected<cv::Mat, std::string> pyr_down(const cv::Mat &img) {
+    if (img.type() != CV_8UC1)
+        return std::unexpected("Unexpected image type; require CV_8UC1 (grayscale).");
+
+    if (img.rows < 2 || img.cols < 2)
+        return std::unexpected(std::format("Image too small to downsample: {}x{}", img.rows, img.cols));
+
+    const int out_rows{(img.rows + 1) / 2};
+    const int out_cols{(img.cols + 1) / 2};
+    const int half_size{static_cast<int>(binomial.size()) / 2};
+
+    // Horizontal pass, only at the columns that are kept; sums fit in 16 bits (255 * 16)
+    cv::Mat tmp{};
+    tmp.create(img.rows, out_cols, CV_16SC1);
+
+    for (int y = 0; y < img.rows; y++) {
+        const auto *img_row{img.ptr<std::uint8_t>(y)};
+        auto *tmp_row{tmp.ptr<std::int16_t>(y)};
+
+        for (int x = 0; x < out_cols; x++) {
+            int acc{};
+            for (int k = 0; k < static_cast<int>(binomial.size()); k++)
+                acc += binomial[k] * img_row[std::clamp(2 * x + k - half_size, 0, img.cols - 1)];
+            tmp_row[x] = static_cast<std::int16_t>(acc);
+        }
+    }
+
+    // Vertical pass, only at the rows that are kept
+    cv::Mat down{};
+    down.create(out_rows, out_cols, CV_8UC1);
+
+    for (int y = 0; y < out_rows; y++) {
+        auto *down_row{down.ptr<std::uint8_t>(y)};
+
+        for (int x = 0; x < out_cols; x++) {
+            int acc{};
+            for (int k = 0; k < static_cast<int>(binomial.size()); k++)
+                acc += binomial[k] * tmp.ptr<std::int16_t>(std::clamp(2 * y + k - half_size, 0, img.rows - 1))[x];
+            down_row[x] = static_cast<std::uint8_t>((acc + 128) / 256);
+        }
+    }
+
+    return down;
+}
+
+std::expected<std::vector<cv::Mat>, std::string> build_gaussian_pyramid(const cv::Mat &img, const int levels) {
+    if (levels < 1)
+        return std::unexpected(std::format("Pyramid needs at least one level: {}", levels));
+
+    std::vector<cv::Mat> pyramid{img};
+
+    while (static_cast<int>(pyramid.size()) < levels) {
+        const cv::Mat &prev{pyramid.back()};
+        if ((std::min(prev.rows, prev.cols) + 1) / 2 < min_level_side)
+            break;
+
+        const auto down_expected{pyr_down(prev)};
+        if (!down_expected.has_value())
+            return std::unexpected(down_expected.error());
+
+        pyramid.emplace_back(down_expected.value());
+    }
+
+    return pyramid;
+}
+
+std::expected<MultiScaleResult, std::string> multiscale_canny(const cv::Mat &img, const CannyCfg &cfg, const int levels,
+                                                              const ScaleCombine combine) {
+    return multiscale_canny({}, img, cfg, levels, combine, false);
+}
+
+std::expected<MultiScaleResult, std::string> multiscale_canny(const std::string &img_name, const cv::Mat &img,
+                                                              const CannyCfg &cfg, const int levels,
+                                                              const ScaleCombine combine, bool save_intermediates) {
+    const auto pyramid_expected{build_gaussian_pyramid(img, levels)};
+    if (!pyramid_expected.has_value())
+        return std::unexpected{"Failed to build gaussian pyramid: " + pyramid_expected.error()};
+
+    const std::vector<cv::Mat> &pyramid{pyramid_expected.value()};
+
+    // --- Per-level Edges ---
+    // The gradients are what confirm_edges localizes coarse edges by
+    using enum CannyStage;
+    const CannyStage gradients{combine == ScaleCombine::CoarseToFine ? Magnitude | Direction : CannyStage{}};
+    const CannyStage stages{Edges | gradients | (save_intermediates ? Magnitude | Nms : CannyStage{})};
+
+    std::vector<cv::Mat> level_edges{};
+    std::vector<cv::Mat> level_mag{};
+    std::vector<cv::Mat> level_dir{};
+    MultiScaleResult result{};
+
+    for (std::size_t l = 0; l < pyramid.size(); l++) {
+        const auto outputs_expected{run_canny(pyramid[l], cfg, stages)};
+        if (!outputs_expected.has_value())
+            return std::unexpected{std::format("Failed to run canny on level {}: {}", l, outputs_expected.error())};
+
+        // --- Save Intermediates ---
+        if (save_intermediates) {
+            const auto mag_sv_expected{
+                save_image(*outputs_expected->magnitude, cfg.out_dir, img_name, std::format("magnitude_L{}", l),
+                           cfg.sigma)};
+            if (!mag_sv_expected.has_value())
+                return std::unexpected{std::format("Failed to save level {} grad_mag: {}", l, mag_sv_expected.error())};
+
+            const auto nms_sv_expected{
+                save_image(*outputs_expected->nms, cfg.out_dir, img_name, std::format("nms_L{}", l), cfg.sigma)};
+            if (!nms_sv_expected.has_value())
+                return std::unexpected{std::format("Failed to save level {} nms: {}", l, nms_sv_expected.error())};
+        }
+
+        level_edges.emplace_back(*outputs_expected->edges);
+        level_mag.emplace_back(outputs_expected->magnitude.value_or(cv::Mat{}));
+        level_dir.emplace_back(outputs_expected->direction.value_or(cv::Mat{}));
+        result.thresholds.emplace_back(*outputs_expected->thresholds);
+    }
+
+    // --- Combine ---
+    switch (combine) {
+    case ScaleCombine::CoarseToFine: {
+        cv::Mat confirmed{level_edges.back()};
+        for (int l = static_cast<int>(level_edges.size()) - 2; l >= 0; l--)
+            confirmed = confirm_edges(level_edges[l], level_mag[l], level_dir[l], confirmed);
+
+        result.edges = confirmed;
+        break;
+    }
+    case ScaleCombine::Union: {
+        result.edges = level_edges.front().clone();
+        for (std::size_t l = 1; l < level_edges.size(); l++)
+            union_edges(result.edges, level_edges[l], static_cast<int>(l));
+        break;
+    }
+    }
+
+    return result;
+}
+
+} // namespace kd
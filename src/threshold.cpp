@@ -0,0 +1,117 @@
+#include <knr/threshold.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <format>
+
+namespace kd {
+
+namespace {
+
+constexpr float low_high_ratio{0.5f}; // Canny's own suggestion lies b/w 1:2 and 1:3
+
+// Otsu's method over bins [1, 255]; bin 0 holds suppressed pixels, which aren't responses at all
+int otsu_threshold(const Histogram &hist, const std::uint64_t total) {
+    double sum_all{};
+    for (int i = 1; i < 256; i++)
+        sum_all += static_cast<double>(i) * hist[i];
+
+    std::uint64_t w0{};
+    double sum0{};
+    double best_var{-1};
+    int best_t{1};
+
+    for (int t = 1; t < 255; t++) {
+        w0 += hist[t];
+        sum0 += static_cast<double>(t) * hist[t];
+
+        const std::uint64_t w1{total - w0};
+        if (w0 == 0)
+            continue;
+        if (w1 == 0)
+            break;
+
+        const double m0{sum0 / w0};
+        const double m1{(sum_all - sum0) / w1};
+        const double between_var{static_cast<double>(w0) * w1 * (m0 - m1) * (m0 - m1)};
+
+        if (between_var > best_var) {
+            best_var = between_var;
+            best_t   = t;
+        }
+    }
+
+    return best_t;
+}
+
+int percentile_threshold(const Histogram &hist, const std::uint64_t total, const float percentile) {
+    const auto target{static_cast<std::uint64_t>(std::ceil(percentile * total))};
+
+    std::uint64_t cum{};
+    for (int i = 1; i < 256; i++) {
+        cum += hist[i];
+        if (cum >= target)
+            return i;
+    }
+
+    return 255;
+}
+
+} // namespace
+
+std::string_view to_string(const ThresholdMode mode) {
+    switch (mode) {
+    case ThresholdMode::Fixed:
+        return "fixed";
+    case ThresholdMode::Otsu:
+        return "otsu";
+    case ThresholdMode::Percentile:
+        return "percentile";
+    }
+
+    return "invalid";
+}
+
+std::expected<ThresholdMode, std::string> parse_threshold_mode(std::string_view name) {
+    if (name == "fixed")
+        return ThresholdMode::Fixed;
+
+    if (name == "otsu")
+        return ThresholdMode::Otsu;
+
+    if (name == "percentile")
+        return ThresholdMode::Percentile;
+
+    return std::unexpected(std::format("Unknown threshold mode: {}", name));
+}
+
+std::expected<Thresholds, std::string> select_thresholds(const Histogram &hist, const ThresholdMode mode,
+                                                         const float percentile) {
+    if (mode == ThresholdMode::Percentile && (percentile <= 0 || percentile >= 1))
+        return std::unexpected(std::format("Percentile must lie in (0,1): {}", percentile));
+
+    std::uint64_t total{};
+    for (int i = 1; i < 256; i++)
+        total += hist[i];
+
+    int high{};
+    switch (mode) {
+    case ThresholdMode::Otsu:
+        high = otsu_threshold(hist, total);
+        break;
+    case ThresholdMode::Percentile:
+        high = percentile_threshold(hist, total, percentile);
+        break;
+    default:
+        return std::unexpected(std::format("Threshold mode '{}' doesn't select thresholds", to_string(mode)));
+    }
+
+    // NOTE: w/ no responses at all (e.g. a flat image) any pair yields an empty edge map; this keeps it valid
+    high = std::clamp(high, 2, 255);
+    const int low{std::clamp(static_cast<int>(std::round(high * low_high_ratio)), 1, high - 1)};
+
+    return Thresholds{low, high};
+}
+
+} // namespace kd
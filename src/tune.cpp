@@ -0,0 +1,277 @@
+#include <knr/gauss.h>
+#include <knr/tune.h>
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <compare>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace kd {
+
+namespace {
+
+constexpr int tune_band_rows{128}; // Output rows each candidate is timed over
+constexpr int tune_reps{2};        // Best-of-N, to shrug off a cold cache/page faults on the first run
+
+// Timing only ever covers a fixed band of rows, so rows don't matter; widths are bucketed to the next power of two
+// so a corpus of varied sizes (or every level of a pyramid) doesn't re-tune per exact resolution
+struct TuneKey {
+    int filter_size;
+    int col_bucket;
+    int max_threads;
+
+    auto operator<=>(const TuneKey &) const = default;
+};
+
+using TuneTable = std::map<TuneKey, ConvPlan>;
+
+std::mutex memo_mtx{}; // Guards tune_memo & provisional; only ever held for a lookup/insert
+TuneTable tune_memo{};
+std::set<TuneKey> provisional{}; // Tuned under contention; used, but re-tuned once the process is otherwise idle
+
+// Serializes timing (& the cache file); candidates racing each other for cores would skew the measurements
+std::mutex timing_mtx{};
+
+std::optional<ConvPlan> memo_lookup(const TuneKey &key, const bool contended) {
+    const std::lock_guard lock{memo_mtx};
+
+    if (const auto it{tune_memo.find(key)}; it != tune_memo.end() && (contended || !provisional.contains(key)))
+        return it->second;
+
+    return std::nullopt;
+}
+
+void memo_insert(const TuneKey &key, const ConvPlan &plan, const bool contended) {
+    const std::lock_guard lock{memo_mtx};
+    tune_memo[key] = plan;
+
+    if (contended)
+        provisional.insert(key);
+    else
+        provisional.erase(key);
+}
+
+int core_count() { return std::max(1, static_cast<int>(std::thread::hardware_concurrency())); }
+
+TuneTable load_tune_cache(const std::string &path) {
+    TuneTable table{};
+
+    std::ifstream in{path};
+    std::string line{};
+
+    while (std::getline(in, line)) {
+        if (line.empty() || line.starts_with('#'))
+            continue;
+
+        std::istringstream ss{line};
+        TuneKey key{};
+        std::string backend{};
+        int threads{};
+
+        if (!(ss >> key.filter_size >> key.col_bucket >> key.max_threads >> backend >> threads))
+            continue;
+
+        const auto backend_expected{parse_conv_backend(backend)};
+        if (!backend_expected.has_value() || threads < 1)
+            continue;
+
+        table[key] = {backend_expected.value(), threads};
+    }
+
+    return table;
+}
+
+std::expected<void, std::string> save_tune_cache(const std::string &path, const TuneTable &table) {
+    const std::filesystem::path cache_path{path};
+
+    if (cache_path.has_parent_path() && !std::filesystem::exists(cache_path.parent_path())) {
+        std::error_code e;
+        if (!std::filesystem::create_directories(cache_path.parent_path(), e))
+            return std::unexpected("Failed to create directory: " + e.message());
+    }
+
+    // Write to a sibling & rename over, so concurrent runs never read a half-written cache
+    const auto tmp_path{std::format("{}.{}", path, std::random_device{}())};
+
+    {
+        std::ofstream out{tmp_path};
+        out << "# filter_size col_bucket max_threads backend threads\n";
+        for (const auto &[key, plan] : table)
+            out << std::format("{} {} {} {} {}\n", key.filter_size, key.col_bucket, key.max_threads,
+                               to_string(plan.backend), plan.threads);
+
+        if (!out)
+            return std::unexpected("Failed to write tuning cache: " + tmp_path);
+    }
+
+    std::error_code e;
+    std::filesystem::rename(tmp_path, cache_path, e);
+    if (e) {
+        std::filesystem::remove(tmp_path, e);
+        return std::unexpected("Failed to replace tuning cache: " + path);
+    }
+
+    return {};
+}
+
+struct Timing {
+    double seconds;
+    cv::Mat fx; // Kept to check candidates agree
+};
+
+std::expected<Timing, std::string> time_plan(const ConvPlan &plan, const cv::Mat &band, const cv::Mat &gx,
+                                             const std::pair<cv::Mat, cv::Mat> &sep) {
+    Timing timing{std::numeric_limits<double>::max(), {}};
+
+    for (int rep = 0; rep < tune_reps; rep++) {
+        const auto start{std::chrono::steady_clock::now()};
+
+        const auto f_expected{plan.backend == ConvBackend::Direct
+                                  ? convolve_rescaled_through_image(band, gx, plan.threads)
+                                  : convolve_separable_through_image(band, sep.first, sep.second, plan.threads)};
+        if (!f_expected.has_value())
+            return std::unexpected(f_expected.error());
+
+        const std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+        timing.seconds = std::min(timing.seconds, elapsed.count());
+        timing.fx      = f_expected.value();
+    }
+
+    return timing;
+}
+
+bool same_output(const cv::Mat &a, const cv::Mat &b) {
+    if (a.size() != b.size() || a.type() != b.type())
+        return false;
+
+    for (int y = 0; y < a.rows; y++)
+        if (std::memcmp(a.ptr<std::uint8_t>(y), b.ptr<std::uint8_t>(y), a.cols * a.elemSize()) != 0)
+            return false;
+
+    return true;
+}
+
+} // namespace
+
+std::string_view to_string(const ConvBackend backend) {
+    switch (backend) {
+    case ConvBackend::Direct:
+        return "direct";
+    case ConvBackend::Separable:
+        return "separable";
+    }
+
+    return "invalid";
+}
+
+std::expected<ConvBackend, std::string> parse_conv_backend(std::string_view name) {
+    if (name == "direct")
+        return ConvBackend::Direct;
+
+    if (name == "separable")
+        return ConvBackend::Separable;
+
+    return std::unexpected(std::format("Unknown convolution backend: {}", name));
+}
+
+std::string default_tune_cache_path() {
+    if (const char *xdg{std::getenv("XDG_CACHE_HOME")}; xdg != nullptr && *xdg != '\0')
+        return std::format("{}/knr/tune.cache", xdg);
+
+    if (const char *home{std::getenv("HOME")}; home != nullptr && *home != '\0')
+        return std::format("{}/.cache/knr/tune.cache", home);
+
+    return {};
+}
+
+std::expected<ConvPlan, std::string> select_conv_plan(const cv::Mat &img_padded, const cv::Mat &gx,
+                                                      const std::pair<cv::Mat, cv::Mat> &sep, const int max_threads,
+                                                      const std::string &cache_path, const bool contended) {
+    const int budget{max_threads > 0 ? std::min(max_threads, core_count()) : core_count()};
+    const int cols{img_padded.cols - (gx.cols - 1)};
+    const TuneKey key{gx.rows, static_cast<int>(std::bit_ceil(static_cast<unsigned>(std::max(cols, 1)))), budget};
+
+    // Fast path; jobs whose plan is known never wait on another job's tuning run
+    if (const auto plan{memo_lookup(key, contended)}; plan.has_value())
+        return plan.value();
+
+    const std::lock_guard timing_lock{timing_mtx};
+
+    // Someone may have tuned this key while we waited
+    if (const auto plan{memo_lookup(key, contended)}; plan.has_value())
+        return plan.value();
+
+    TuneTable table{cache_path.empty() ? TuneTable{} : load_tune_cache(cache_path)};
+
+    if (const auto it{table.find(key)}; it != table.end()) {
+        memo_insert(key, it->second, false);
+        return it->second;
+    }
+
+    // --- Time every candidate on a band of the image ---
+    const cv::Mat band{img_padded.rowRange(0, std::min(img_padded.rows, gx.rows - 1 + tune_band_rows))};
+
+    std::vector<int> thread_counts{};
+    for (int t = 1; t < budget; t *= 2)
+        thread_counts.emplace_back(t);
+    thread_counts.emplace_back(budget);
+
+    ConvPlan best_plan{ConvBackend::Direct, 1};
+    double best_time{std::numeric_limits<double>::max()};
+    cv::Mat reference{};
+
+    for (const auto backend : {ConvBackend::Direct, ConvBackend::Separable}) {
+        for (const int threads : thread_counts) {
+            const ConvPlan plan{backend, threads};
+
+            const auto timing_expected{time_plan(plan, band, gx, sep)};
+            if (!timing_expected.has_value())
+                return std::unexpected(std::format("Failed to time {} backend w/ {} threads: {}", to_string(backend),
+                                                   threads, timing_expected.error()));
+
+            const auto &[seconds, fx]{timing_expected.value()};
+
+            // Dispatch picks whichever is fastest on this machine, so only bit-identical candidates may compete
+            if (reference.empty())
+                reference = fx;
+            else if (!same_output(reference, fx))
+                return std::unexpected(std::format("{} backend w/ {} threads disagrees w/ the direct backend",
+                                                   to_string(backend), threads));
+
+            if (seconds < best_time) {
+                best_time = seconds;
+                best_plan = plan;
+            }
+        }
+    }
+
+    memo_insert(key, best_plan, contended);
+
+    // Failing to persist only costs a re-tune next run, so it isn't worth failing the detection over
+    // Timings skewed by other jobs aren't persisted, lest every later run inherit a plan picked on a busy machine
+    if (!cache_path.empty() && !contended) {
+        table[key] = best_plan;
+        (void)save_tune_cache(cache_path, table);
+    }
+
+    return best_plan;
+}
+
+} // namespace kd
@@ -2,10 +2,108 @@
 
 #include <opencv2/core/types.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace kd {
 
+namespace {
+
+// One parallel_for_rows call, split into `chunks` chunks that whoever is free claims in turn
+struct RowPass {
+    const std::function<void(int, int)> *body;
+    int begin;
+    int end;
+    int chunk;
+    int chunks;
+    std::atomic<int> next{};
+    std::atomic<int> done{};
+
+    // Runs chunks until none are left to claim
+    void drain() {
+        for (int c = next.fetch_add(1); c < chunks; c = next.fetch_add(1)) {
+            const int lo{begin + c * chunk};
+            (*body)(lo, std::min(lo + chunk, end));
+
+            if (done.fetch_add(1) + 1 == chunks)
+                done.notify_all();
+        }
+    }
+};
+
+// Process-wide helpers, started once; passes then don't pay for thread start-up, which would otherwise dwarf short
+// ones (& skew the autotuner's timings)
+// The calling thread drains its own pass too, so it never waits on helpers tied up in other passes for long
+class RowPool {
+  public:
+    explicit RowPool(const unsigned helpers) {
+        helpers_.reserve(helpers);
+        for (unsigned i = 0; i < helpers; i++)
+            helpers_.emplace_back([this](std::stop_token stop) { work(stop); });
+    }
+
+    void run(const std::function<void(int, int)> &body, const int begin, const int end, const int chunk) {
+        // Shared, as a helper may still hold the pass (w/ nothing left to claim) after it's done & run has returned
+        const auto pass{std::make_shared<RowPass>(&body, begin, end, chunk, (end - begin + chunk - 1) / chunk)};
+
+        {
+            const std::lock_guard lock{mtx_};
+            passes_.emplace_back(pass);
+        }
+        cv_.notify_all();
+
+        pass->drain();
+        retire(pass);
+
+        for (int d = pass->done.load(); d < pass->chunks; d = pass->done.load())
+            pass->done.wait(d);
+    }
+
+  private:
+    void retire(const std::shared_ptr<RowPass> &pass) {
+        const std::lock_guard lock{mtx_};
+        std::erase(passes_, pass);
+    }
+
+    void work(std::stop_token stop) {
+        while (true) {
+            std::shared_ptr<RowPass> pass{};
+            {
+                std::unique_lock lock{mtx_};
+                cv_.wait(lock, stop, [this] { return !passes_.empty(); });
+
+                if (passes_.empty())
+                    return;
+
+                pass = passes_.front();
+            }
+
+            pass->drain();
+            retire(pass);
+        }
+    }
+
+    std::deque<std::shared_ptr<RowPass>> passes_{}; // Still w/ chunks to claim, oldest first
+    std::mutex mtx_{};
+    std::condition_variable_any cv_{};
+    std::vector<std::jthread> helpers_{}; // Last, so helpers are joined before the queue goes away
+};
+
+RowPool &row_pool() {
+    // The calling thread makes up the last core
+    static RowPool pool{std::max(std::thread::hardware_concurrency(), 1u) - 1};
+    return pool;
+}
+
+} // namespace
+
 cv::Mat pad_image(const cv::Mat &img, const int padding) {
     cv::Mat padded{img.rows + 2 * padding, img.cols + 2 * padding, img.type(), cv::Scalar(0)};
 
@@ -18,5 +116,36 @@ cv::Mat pad_image(const cv::Mat &img, const int padding) {
     return padded;
 }
 
+void parallel_for_rows(const int begin, const int end, const int threads, const std::function<void(int, int)> &body) {
+    const int n{end - begin};
+    const int workers{std::clamp(threads, 1, std::max(n, 1))};
+
+    if (workers == 1) {
+        body(begin, end);
+        return;
+    }
+
+    row_pool().run(body, begin, end, (n + workers - 1) / workers);
+}
+
 std::uint8_t operator+(const GradientDir gd) { return std::to_underlying(gd); }
+
+std::optional<Px> gradient_step(const GradientDir gd) {
+    using enum GradientDir;
+
+    switch (gd) {
+    case E_W:
+        return Px{0, 1};
+    case NE_SW:
+        return Px{1, 1};
+    case N_S:
+        return Px{1, 0};
+    case NW_SE:
+        return Px{1, -1};
+    case Invalid:
+        break;
+    }
+
+    return std::nullopt;
+}
 } // namespace kd